@@ -1,39 +1,43 @@
 #include "LifeAPI.h"
+#include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
+#if __cplusplus >= 201103L
+	#include <type_traits>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+	#include <immintrin.h>
+#endif
+
+#if __cplusplus >= 201103L
+// States are copied, packed and compared as plain words.
+static_assert(std::is_trivially_copyable<LifeState>::value, "LifeState must stay trivially copyable");
+#endif
 
 LifeState::LifeState()
 {
+	this->gliderRemoval = GLIDERS_EVERY_GEN;
+	this->gliderPeriod = 1;
+	this->catalog = NULL;
+	this->sink = NULL;
 	this->clear();
 }
 
-LifeState::LifeState(const LifeState& rhs)
-{
-	this->gen = rhs.gen;
-	this->min = rhs.min;
-	this->max = rhs.max;
-	this->gliders = rhs.gliders;
-	for (size_t i=0; i<64; ++i)
-	{
-		this->state[i] = rhs.state[i];
-	}
-}
-
-LifeState::LifeState(const char* rle) 
+CellList::CellList(const char* rle, int x0, int y0)
 {
 	char ch;
 	int cnt = 0;
 	int i = 0;
-	int x = 0;
-	int y = 0;
+	int x = x0;
+	int y = y0;
 	bool error = false;
 
-	this->clear();
-
 	while((ch = rle[i]) != '\0')
 	{
 
@@ -50,7 +54,8 @@ LifeState::LifeState(const char* rle)
 
 			for(int j = 0; j < cnt; j++)
 			{
-				this->setCell(x, y, 1);
+				Cell c = {x, y};
+				this->push_back(c);
 				x++;
 			}
 
@@ -70,7 +75,7 @@ LifeState::LifeState(const char* rle)
 			if(cnt == 0)
 				cnt = 1;
 			y += cnt;
-			x = 0;
+			x = x0;
 			cnt = 0;
 		}
 		else if(ch == '!')
@@ -114,9 +119,22 @@ LifeState::LifeState(const char* rle)
 	{
 		std::cerr << "While parsing RLE:\n" << rle << std::endl;
 	}
+}
+
+LifeState::LifeState(const char* rle) 
+{
+	this->gliderRemoval = GLIDERS_EVERY_GEN;
+	this->gliderPeriod = 1;
+	this->catalog = NULL;
+	this->sink = NULL;
+	this->clear();
 
-	this->min = 0;
-	this->max = 64 - 1;
+	CellList cells(rle);
+	for (CellList::const_iterator it = cells.begin(); it != cells.end(); ++it)
+	{
+		this->setCell(it->x, it->y, 1);
+	}
+	this->recalculateBounds();
 	this->gen = 0;
 }
 
@@ -145,7 +163,7 @@ LifeState LifeState::makeRandomState()
 	{
 		result.state[i] = PRNG::rand64();
 	}
-	result.recalculateMinMax();
+	result.recalculateBounds();
 	return result;
 }
 
@@ -159,34 +177,18 @@ LifeState LifeState::makeRect(int x, int y, int w, int h)
 			result.setCell(x+dx, y+dy, 1);
 		}
 	}
-	result.recalculateMinMax();
-	return result;
-}
-
-// Apply convolution of `*this` and `rhs`.
-LifeState LifeState::operator*(const CellList& rhs) const
-{
-	LifeState result;
-	for(CellList::const_iterator it=rhs.begin(); it != rhs.end(); ++it)
-	{
-		result |= this->transform(it->x, it->y);
-	}
+	result.recalculateBounds();
 	return result;
 }
-// Apply convolution of `*this` and `rhs`.
-LifeState LifeState::operator*(const LifeState& rhs) const
-{
-	return (*this) * (rhs.toCellList());
-}
 
 static inline uint64_t CirculateLeft(uint64_t x, int k=1)
 {
-	return (x << k) | (x >> (64 - k));
+	return (x << k) | (x >> ((64 - k) & 63));
 }
 
 static inline uint64_t CirculateRight(uint64_t x, int k=1)
 {
-	return (x >> k) | (x << (64 - k));
+	return (x >> k) | (x << ((64 - k) & 63));
 }
 
 static inline void Set(uint64_t *state, int x, int y)
@@ -204,65 +206,233 @@ static inline int Get(const uint64_t *state, int x, int y)
 	return (state[x] & (1ULL << y)) >> y;
 }
 
-inline void LifeState::expandMinMax()
+static inline int LowestBit(uint64_t x)
 {
-    this->min -= 2;
-    if (this->min < 0) this->min = 0;
-    this->max += 2;
-    if (this->max >= 64) this->max = 64 - 1;
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward64(&i, x);
+	return (int)i;
+#else
+	return __builtin_ctzll(x);
+#endif
 }
 
-void LifeState::refitMinMax()
+static inline int HighestBit(uint64_t x)
 {
-	int min = this->min;
-	int max = this->max;
-	uint64_t * states = this->state;
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanReverse64(&i, x);
+	return (int)i;
+#else
+	return 64 - 1 - __builtin_clzll(x);
+#endif
+}
 
-	for(int i = min; i <= max; i++)
+// Bit p is set if bits p ... p + length - 1 of gaps are all set, in
+// log2(length) steps.
+static inline uint64_t RunStarts(uint64_t gaps, int length)
+{
+	for(int done = 1; done < length; )
 	{
-		if(states[i] != 0)
-		{
-			this->min = i;
-			break;
-		}
+		int step = std::min(done, length - done);
+		gaps &= gaps >> step;
+		done += step;
 	}
+	return gaps;
+}
 
-	for(int i = max; i >= min; i--)
+// The shortest circular run [start, start + length) of bits, mod 64, that
+// covers every set bit of mask. Length 0 means mask is empty.
+static void CircularSpan(uint64_t mask, int& start, int& length)
+{
+	if(mask == 0 || mask == ~0ULL)
 	{
-		if(states[i] != 0)
-		{
-		    this->max = i;
-		    break;
-		}
+		start = 0;
+		length = (mask == 0) ? 0 : 64;
+		return;
+	}
+	int lo = LowestBit(mask);
+	int hi = HighestBit(mask);
+	start = lo;
+	length = hi - lo + 1;
+	// The run of zeros across the seam is 64 - length long. Cut at a
+	// longer one between lo and hi instead, if there is one.
+	uint64_t gaps = ~mask & (~0ULL >> (64 - 1 - hi)) & (~0ULL << lo);
+	int n = 64 - length + 1;
+	uint64_t longest = RunStarts(gaps, n);
+	if(longest == 0)
+	{
+		return;
+	}
+	for(uint64_t next = longest & (longest >> 1); next != 0; next &= next >> 1)
+	{
+		longest = next;
+		n++;
 	}
-    this->expandMinMax();
+	start = LowestBit(longest) + n;
+	length = 64 - n;
 }
 
-void LifeState::recalculateMinMax()
+// OR of x rotated left by 0 ... length - 1, in log2(length) steps.
+static inline uint64_t SpreadRun(uint64_t x, int length)
 {
-	this->min = 64 - 1;
-	this->max = 0;
-	uint64_t * states = this->state;
+	for(int done = 1; done < length; )
+	{
+		int step = std::min(done, length - done);
+		x |= CirculateLeft(x, step);
+		done += step;
+	}
+	return x;
+}
 
+// Separable: each row is spread over h bits, then the rows over w rows,
+// both by doubling.
+LifeState LifeState::dilate(int x, int y, int w, int h) const
+{
+	assert(w > 0 && h > 0);
+	LifeState result;
+	if(this->rows == 0)
+	{
+		return result;
+	}
+	w = std::min(w, 64);
+	h = std::min(h, 64);
+	uint64_t spread[64];
 	for(int i = 0; i < 64; i++)
 	{
-		if(states[i] != 0)
+		spread[i] = (this->state[i] != 0) ? SpreadRun(this->state[i], h) : 0;
+	}
+	for(int done = 1; done < w; )
+	{
+		int step = std::min(done, w - done);
+		uint64_t next[64];
+		for(int i = 0; i < 64; i++)
 		{
-			this->min = i;
-			break;
+			next[i] = spread[i] | spread[(i - step) & 63];
+		}
+		std::copy(next, next + 64, spread);
+		done += step;
+	}
+	for(int i = 0; i < 64; i++)
+	{
+		result.state[(i + x) & 63] = CirculateLeft(spread[i], y & 63);
+	}
+	result.recalculateBounds();
+	return result;
+}
+
+// Apply convolution of `*this` and `rhs`. Kernel rows with the same cells
+// share one spread word per live row; a rectangular kernel goes through
+// dilate().
+LifeState LifeState::operator*(const LifeState& rhs) const
+{
+	// Kernel row j at offset j - 32, with bit b a rotation by b.
+	uint64_t masks[64];
+	uint64_t groups[64];
+	int groupCount = 0;
+	for(uint64_t rows = rhs.rows; rows != 0; rows &= rows - 1)
+	{
+		int j = LowestBit(rows);
+		uint64_t mask = CirculateRight(rhs.state[j], 32);
+		if(mask == 0)
+		{
+			continue;
+		}
+		int g = 0;
+		while(g < groupCount && masks[g] != mask)
+		{
+			g++;
+		}
+		if(g == groupCount)
+		{
+			masks[g] = mask;
+			groups[g] = 0;
+			groupCount++;
+		}
+		groups[g] |= 1ULL << j;
+	}
+	if(groupCount == 1)
+	{
+		int xStart, xLength, yStart, yLength;
+		CircularSpan(groups[0], xStart, xLength);
+		CircularSpan(masks[0], yStart, yLength);
+		if(__builtin_popcountll(groups[0]) == xLength && __builtin_popcountll(masks[0]) == yLength)
+		{
+			return this->dilate(xStart - 32, yStart, xLength, yLength);
 		}
 	}
 
-	for(int i = 64 - 1; i >= 0; i--)
+	LifeState result;
+	for(uint64_t rows = this->rows; rows != 0; rows &= rows - 1)
 	{
-		if(states[i] != 0)
+		int i = LowestBit(rows);
+		uint64_t word = this->state[i];
+		for(int g = 0; g < groupCount; g++)
 		{
+			uint64_t spread = 0;
+			for(uint64_t mask = masks[g]; mask != 0; mask &= mask - 1)
+			{
+				spread |= CirculateLeft(word, LowestBit(mask));
+			}
+			for(uint64_t js = groups[g]; js != 0; js &= js - 1)
+			{
+				result.state[(i + LowestBit(js) - 32) & 63] |= spread;
+			}
+		}
+	}
+	result.recalculateBounds();
+	return result;
+}
 
-			this-> max = i;
-			break;
+LifeState LifeState::operator*(const CellList& rhs) const
+{
+	return (*this) * rhs.toLifeState();
+}
+
+// Tighten the bounds to the live rows in [start, start + length), mod 64.
+// Every other row must already be empty.
+void LifeState::refitBounds(int start, int length)
+{
+	uint64_t rows = 0;
+	uint64_t cols = 0;
+	for(int k = 0; k < length; k++)
+	{
+		int i = (start + k) & 63;
+		if(this->state[i] != 0)
+		{
+			rows |= 1ULL << i;
+			cols |= this->state[i];
 		}
 	}
-	this->expandMinMax();
+	this->rows = rows;
+	this->cols = cols;
+}
+
+void LifeState::refitBounds()
+{
+	int start, length;
+	CircularSpan(this->rows, start, length);
+	this->refitBounds(start, length);
+}
+
+void LifeState::recalculateBounds()
+{
+	this->refitBounds(0, 64);
+}
+
+bool LifeState::getBoundingBox(int& x, int& y, int& w, int& h) const
+{
+	LifeState exact(*this);
+	exact.refitBounds();
+	if(exact.rows == 0)
+	{
+		return false;
+	}
+	CircularSpan(exact.rows, x, w);
+	CircularSpan(exact.cols, y, h);
+	x -= 32;
+	y -= 32;
+	return true;
 }
 
 // Get-Set operations.
@@ -272,6 +442,8 @@ void LifeState::setCell(int x, int y, int val)
 	if(val)
 	{
 		Set(this->state, (x + 32) % 64, (y + 32) % 64);
+		this->rows |= 1ULL << ((x + 32) % 64);
+		this->cols |= 1ULL << ((y + 32) % 64);
 	}
 	else
 	{
@@ -284,28 +456,216 @@ int LifeState::getCell(int x, int y) const
 	return Get(this->state, (x + 32) % 64, (y + 32) % 64);
 }
 
-uint64_t LifeState::getHash() const
+// MurmurHash3's 64-bit finalizer.
+static inline uint64_t MixHash(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33;
+	x *= 0xC4CEB9FE1A85EC53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+uint64_t LifeState::rowHash(int i, uint64_t word, int seed)
 {
-	uint64_t result = 0;
+	if (word == 0)
+	{
+		return 0;
+	}
+	// Both the word and the row key are mixed before they meet, so two rows
+	// can't cancel out in the XOR by differing only in the key bits.
+	static const uint64_t keys[2] = {0x9E3779B97F4A7C15ULL, 0xD1B54A32D192ED03ULL};
+	uint64_t key = MixHash((uint64_t)((i & 63) + 1) * keys[seed & 1]);
+	return MixHash(MixHash(word) + key);
+}
 
-	for(int i = this->min; i <= this->max; i++)
+// With translationInvariant the rows and bits are counted from the
+// corner of the bounding box rather than from the torus origin.
+// Bit p is set if bits p ... p + length - 1 of gaps, around the torus,
+// are all set.
+static inline uint64_t CircularRunStarts(uint64_t gaps, int length)
+{
+	for(int done = 1; done < length; )
 	{
-		result += CirculateRight(this->state[i], i);
-		result += CirculateLeft(this->state[i], (i + 8) % 47);
+		int step = std::min(done, length - done);
+		gaps &= CirculateRight(gaps, step);
+		done += step;
 	}
-	return result;
+	return gaps;
+}
+
+// Where a translation-invariant normal form can start a nonempty pattern
+// along one axis, a bit per start: just past each of the longest runs of
+// zeros in mask, or anywhere if it has none.
+static uint64_t GapStarts(uint64_t mask)
+{
+	int start, length;
+	CircularSpan(mask, start, length);
+	if(length == 64)
+	{
+		return ~0ULL;
+	}
+	int gap = 64 - length;
+	return CirculateLeft(CircularRunStarts(~mask, gap), gap);
+}
+
+// The starts from which counts, read around the torus, is least.
+static uint64_t LeastStarts(uint64_t starts, const int* counts)
+{
+	uint64_t least = 0;
+	int best = -1;
+	for(uint64_t rest = starts; rest != 0; rest &= rest - 1)
+	{
+		int p = LowestBit(rest);
+		int cmp = -1;
+		if(best >= 0)
+		{
+			int k = 0;
+			while(k < 64 && counts[(p + k) & 63] == counts[(best + k) & 63])
+			{
+				k++;
+			}
+			cmp = (k == 64) ? 0 : counts[(p + k) & 63] - counts[(best + k) & 63];
+		}
+		if(cmp < 0)
+		{
+			least = 0;
+			best = p;
+		}
+		if(cmp <= 0)
+		{
+			least |= 1ULL << p;
+		}
+	}
+	return least;
+}
+
+// Each candidate start is a translate-independent choice, so ties
+// between equally long gaps are narrowed down by the cells per row (or
+// per column) rather than by where the gaps happen to be.
+void LifeState::getNormalStarts(uint64_t& xs, uint64_t& ys, bool narrow) const
+{
+	uint64_t rows = 0;
+	uint64_t cols = 0;
+	for (uint64_t live = this->rows; live != 0; live &= live - 1)
+	{
+		int i = LowestBit(live);
+		rows |= (uint64_t)(this->state[i] != 0) << i;
+		cols |= this->state[i];
+	}
+	if (rows == 0)
+	{
+		xs = ys = 0;
+		return;
+	}
+	xs = GapStarts(rows);
+	ys = GapStarts(cols);
+	if (narrow && (xs & (xs - 1)) != 0)
+	{
+		int counts[64];
+		for (int i = 0; i < 64; i++)
+		{
+			counts[i] = __builtin_popcountll(this->state[i]);
+		}
+		xs = LeastStarts(xs, counts);
+	}
+	if (narrow && (ys & (ys - 1)) != 0)
+	{
+		// Column counts, bit-sliced over the rows.
+		uint64_t planes[7] = {0};
+		for (uint64_t live = rows; live != 0; live &= live - 1)
+		{
+			uint64_t carry = this->state[LowestBit(live)];
+			for (int k = 0; k < 7 && carry != 0; k++)
+			{
+				uint64_t next = planes[k] & carry;
+				planes[k] ^= carry;
+				carry = next;
+			}
+		}
+		int counts[64];
+		for (int j = 0; j < 64; j++)
+		{
+			counts[j] = 0;
+			for (int k = 0; k < 7; k++)
+			{
+				counts[j] |= (int)((planes[k] >> j) & 1) << k;
+			}
+		}
+		ys = LeastStarts(ys, counts);
+	}
+}
+
+void LifeState::hashFrom(int dx, int dy, uint64_t& lo, uint64_t& hi) const
+{
+	lo = 0;
+	hi = 0;
+	for (uint64_t rows = this->rows; rows != 0; rows &= rows - 1)
+	{
+		int i = LowestBit(rows);
+		uint64_t word = CirculateRight(this->state[i], dy);
+		lo ^= rowHash(i - dx, word, 0);
+		hi ^= rowHash(i - dx, word, 1);
+	}
+}
+
+// The least hash over the normal starts, and the start it came from. Two
+// starts only tie if the pattern maps to itself under the shift between
+// them.
+void LifeState::getNormalHash(uint64_t& lo, uint64_t& hi, int& dx, int& dy) const
+{
+	uint64_t xs, ys;
+	this->getNormalStarts(xs, ys, true);
+	lo = hi = 0;
+	dx = dy = 0;
+	bool first = true;
+	for (uint64_t x = xs; x != 0; x &= x - 1)
+	{
+		for (uint64_t y = ys; y != 0; y &= y - 1)
+		{
+			uint64_t l, h;
+			this->hashFrom(LowestBit(x), LowestBit(y), l, h);
+			if (first || l < lo || (l == lo && h < hi))
+			{
+				lo = l;
+				hi = h;
+				dx = LowestBit(x);
+				dy = LowestBit(y);
+				first = false;
+			}
+		}
+	}
+}
+
+void LifeState::getHash128(uint64_t& lo, uint64_t& hi, bool translationInvariant) const
+{
+	if (translationInvariant)
+	{
+		int dx, dy;
+		this->getNormalHash(lo, hi, dx, dy);
+	}
+	else
+	{
+		this->hashFrom(0, 0, lo, hi);
+	}
+}
+
+uint64_t LifeState::getHash(bool translationInvariant) const
+{
+	uint64_t lo, hi;
+	this->getHash128(lo, hi, translationInvariant);
+	return lo;
 }
 
 int LifeState::getPop() const
 {
 	int pop = 0;
-	int min = this->min;
-	int max = this->max;
 	const uint64_t * const states = this->state;
 
-	for(int i = min; i <= max; i++)
+	for(uint64_t rows = this->rows; rows != 0; rows &= rows - 1)
 	{
-		pop += __builtin_popcountll(states[i]);
+		pop += __builtin_popcountll(states[LowestBit(rows)]);
 	}
 
 	return pop;
@@ -317,23 +677,23 @@ void LifeState::clear()
     {
         this->state[i] = 0;
     }
-    this->min = 0;
-	this->max = 64 - 1;
+    this->rows = 0;
+	this->cols = 0;
 	this->gen = 0;
-    this->gliders.clear();
+	this->gliderCount = 0;
+	this->spaceshipCount = 0;
 }
 
 bool LifeState::isDisjoint(const LifeState& rhs, int dx, int dy) const
 {
-	int min = rhs.min;
-	int max = rhs.max;
 	const uint64_t * rhsState = rhs.state;
 	const uint64_t * mainState = this->state;
 
 	dy %= 64;
 
-	for(int i = min; i <= max; i++)
+	for(uint64_t rows = rhs.rows; rows != 0; rows &= rows - 1)
 	{
+		int i = LowestBit(rows);
 		int curX =  (i+dx)%64;
 		if(((~CirculateRight(mainState[curX], dy)) & rhsState[i]) != rhsState[i])
         {
@@ -345,14 +705,12 @@ bool LifeState::isDisjoint(const LifeState& rhs, int dx, int dy) const
 
 bool LifeState::contains(const LifeState& rhs, int dx, int dy) const
 {
-	int min = rhs.min;
-	int max = rhs.max;
-
 	const uint64_t * mainState = this->state;
 	const uint64_t * rhsState = rhs.state;
 	dy %= 64;
-	for(int i = min; i <= max; i++)
+	for(uint64_t rows = rhs.rows; rows != 0; rows &= rows - 1)
 	{
+		int i = LowestBit(rows);
 		int curX = (i+dx) % 64;
 		if((CirculateRight(mainState[curX], dy) & rhsState[i]) != (rhsState[i]))
 		{
@@ -377,49 +735,256 @@ void LifeState::reverseRows(int firstRow, int lastRow)
 	}
 }
 
-void LifeState::circulateUp(int k)
+// Row i moves to row i + x and bit j to bit j + y, in one pass. The new
+// bounds are found on the way, so a moved pattern doesn't force the
+// next iterate() to process the whole torus.
+void LifeState::move(int x, int y)
 {
-	k %= 64;
-	this->reverseRows(0, 64 - 1);
-	this->reverseRows(0, k - 1);
-	this->reverseRows(k, 64 - 1);
+	int dx = ((x % 64) + 64) % 64;
+	int dy = ((y % 64) + 64) % 64;
+	uint64_t temp[64];
+	std::copy(this->state, this->state + 64, temp);
+
+	uint64_t rows = 0;
+	uint64_t cols = 0;
+	for(int i = 0; i < 64; i++)
+	{
+		uint64_t row = CirculateLeft(temp[(i - dx) & 63], dy);
+		this->state[i] = row;
+		if(row != 0)
+		{
+			rows |= 1ULL << i;
+			cols |= row;
+		}
+	}
+	this->rows = rows;
+	this->cols = cols;
 }
 
-void LifeState::move(int x, int y)
+// x -> -x: row i goes to row 64 - i, so row 0 (x = -32) stays put.
+void LifeState::flipX()
+{
+	this->reverseRows(1, 64 - 1);
+}
+
+// y -> -y: reverse the bits of each row, then rotate bit 63 - j to 64 - j.
+static inline uint64_t ReverseBits(uint64_t x)
+{
+	x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+	x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+	x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+	x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+	return (x >> 32) | (x << 32);
+}
+
+void LifeState::flipY()
 {
 	for(int i = 0; i < 64; i++)
 	{
-		if(y < 0)
-			this->state[i] = CirculateRight(this->state[i], -y);
-		else
-			this->state[i] = CirculateRight(this->state[i], 64 - y);
+		this->state[i] = CirculateLeft(ReverseBits(this->state[i]));
+	}
+}
 
+// (x, y) -> (y, x). Swaps the off-diagonal 32x32 blocks, then the 16x16
+// blocks inside each of those, and so on down to single bits.
+void LifeState::transpose()
+{
+	uint64_t* a = this->state;
+	uint64_t m = 0x00000000FFFFFFFFULL;
+	for(int j = 32; j != 0; j >>= 1, m ^= m << j)
+	{
+		for(int k = 0; k < 64; k = ((k | j) + 1) & ~j)
+		{
+			uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+			a[k | j] ^= t;
+			a[k] ^= t << j;
+		}
 	}
+}
 
-	if(x < 0)
-		this->circulateUp(64 + x);
-	else
-		this->circulateUp(x);
+LifeState LifeState::transform(int dx, int dy) const
+{
+	LifeState result = *this;
+	result.move(dx, dy);
+	return result;
+}
 
-	this->min = 0;
-	this->max = 64 - 1;
+// (dxx, dxy, dyx, dyy) for each Orientation, in enum order.
+static const int OrientationMatrices[8][4] = {
+	{1, 0, 0, 1}, {0, -1, 1, 0}, {-1, 0, 0, -1}, {0, 1, -1, 0},
+	{-1, 0, 0, 1}, {1, 0, 0, -1}, {0, 1, 1, 0}, {0, -1, -1, 0}
+};
+
+LifeState LifeState::transform(Orientation orientation, int dx, int dy) const
+{
+	LifeState result = *this;
+	switch(orientation)
+	{
+	case ORIENT_IDENTITY:
+		break;
+	case ORIENT_ROT90:
+		result.transpose();
+		result.flipX();
+		break;
+	case ORIENT_ROT180:
+		result.flipX();
+		result.flipY();
+		break;
+	case ORIENT_ROT270:
+		result.transpose();
+		result.flipY();
+		break;
+	case ORIENT_FLIP_X:
+		result.flipX();
+		break;
+	case ORIENT_FLIP_Y:
+		result.flipY();
+		break;
+	case ORIENT_DIAG:
+		result.transpose();
+		break;
+	case ORIENT_ANTIDIAG:
+		result.transpose();
+		result.flipX();
+		result.flipY();
+		break;
+	}
+	// move() finds the new row range too.
+	result.move(dx, dy);
+	return result;
 }
 
-void LifeState::flipX()
+// The flips and transpose leave the bounds stale, so they're found again.
+void LifeState::moveToCorner()
 {
-	this->reverseRows(0, 64 - 1);
-	this->move(1, 0);
+	this->recalculateBounds();
+	int x, y, length;
+	CircularSpan(this->rows, x, length);
+	CircularSpan(this->cols, y, length);
+	this->move(-x, -y);
 }
 
-LifeState LifeState::transform(int dx, int dy) const
+// With the pattern in the corner, the flips are a reversal of its rows
+// and of the bits of each row within its height, and the transpose stays
+// in the corner, so one transpose gives all eight orientations. Each is
+// compared with the best so far as row words.
+//
+// The corner is only independent of where the pattern sits if each axis
+// has a single longest empty run. Otherwise every orientation is built in
+// full and tried at each of its normal starts.
+LifeState LifeState::canonical(Orientation* orientation) const
 {
+	uint64_t xs, ys;
+	this->getNormalStarts(xs, ys, false);
+	if (((xs & (xs - 1)) | (ys & (ys - 1))) != 0)
+	{
+		LifeState best;
+		int bestIndex = -1;
+		for (int o = 0; o < 8; o++)
+		{
+			LifeState image = this->transform((Orientation)o);
+			image.getNormalStarts(xs, ys, true);
+			for (uint64_t x = xs; x != 0; x &= x - 1)
+			{
+				for (uint64_t y = ys; y != 0; y &= y - 1)
+				{
+					LifeState candidate = image;
+					candidate.move(-LowestBit(x), -LowestBit(y));
+					int k = 0;
+					while (bestIndex >= 0 && k < 64 && candidate.state[k] == best.state[k])
+					{
+						k++;
+					}
+					if (bestIndex < 0 || (k < 64 && candidate.state[k] < best.state[k]))
+					{
+						best = candidate;
+						bestIndex = o;
+					}
+				}
+			}
+		}
+		if (orientation != NULL)
+		{
+			*orientation = (Orientation)bestIndex;
+		}
+		return best;
+	}
+
+	// Indexed by transposed * 4 + flipX * 2 + flipY.
+	static const Orientation orientations[8] = {
+		ORIENT_IDENTITY, ORIENT_FLIP_Y, ORIENT_FLIP_X, ORIENT_ROT180,
+		ORIENT_DIAG, ORIENT_ROT270, ORIENT_ROT90, ORIENT_ANTIDIAG
+	};
 	LifeState result = *this;
-	result.move(dx, dy);
+	result.moveToCorner();
+	if (orientation != NULL)
+	{
+		*orientation = ORIENT_IDENTITY;
+	}
+	if (result.rows == 0)
+	{
+		return result;
+	}
+	int width = HighestBit(result.rows) + 1;
+	int height = HighestBit(result.cols) + 1;
+	LifeState transposed = result;
+	transposed.transpose();
+	const uint64_t* words[2] = {result.state, transposed.state};
+	int lengths[2] = {width, height};
+	uint64_t reversed[2][64];
+	for (int b = 0; b < 2; b++)
+	{
+		for (int k = 0; k < lengths[b]; k++)
+		{
+			reversed[b][k] = ReverseBits(words[b][k]) >> (64 - lengths[1 - b]);
+		}
+	}
+	int length = std::max(width, height);
+	uint64_t best[64];
+	uint64_t candidate[64];
+	int bestIndex = -1;
+	for (int k = 0; k < 8; k++)
+	{
+		int b = k / 4;
+		const uint64_t* rows = (k & 1) ? reversed[b] : words[b];
+		int n = lengths[b];
+		for (int r = 0; r < length; r++)
+		{
+			candidate[r] = (r >= n) ? 0 : rows[(k & 2) ? n - 1 - r : r];
+		}
+		int r = 0;
+		while (bestIndex >= 0 && r < length && candidate[r] == best[r])
+		{
+			r++;
+		}
+		if (bestIndex < 0 || (r < length && candidate[r] < best[r]))
+		{
+			std::copy(candidate, candidate + length, best);
+			bestIndex = k;
+		}
+	}
+	std::copy(best, best + length, result.state);
+	result.refitBounds(0, length);
+	if (orientation != NULL)
+	{
+		*orientation = orientations[bestIndex];
+	}
 	return result;
 }
 
 LifeState LifeState::transform(int dx, int dy, int dxx, int dxy, int dyx, int dyy) const
 {
+	// The eight orthogonal matrices are word operations.
+	for(int o = 0; o < 8; o++)
+	{
+		const int* m = OrientationMatrices[o];
+		if(m[0] == dxx && m[1] == dxy && m[2] == dyx && m[3] == dyy)
+		{
+			return this->transform((Orientation)o, dx, dy);
+		}
+	}
+
 	LifeState result;
 	for(int i = 0; i < 64; i++)
 	{
@@ -472,11 +1037,14 @@ static inline void add_init(uint64_t& b2, uint64_t& b1, uint64_t &b0, uint64_t&
 	b0 ^= val;
 }
 
-uint64_t inline evolve(const uint64_t& temp, const uint64_t& bU0, const uint64_t& bU1, const uint64_t& bB0, const uint64_t& bB1)
+// tempL and tempR are temp's vertical neighbours. They are passed in so
+// callers without a torus (LifeGrid) can fill in the halo bits.
+uint64_t inline evolve(const uint64_t& temp, const uint64_t& tempL, const uint64_t& tempR,
+	const uint64_t& bU0, const uint64_t& bU1, const uint64_t& bB0, const uint64_t& bB1)
 {
 	uint64_t sum0, sum1, sum2;
-	sum0 = CirculateLeft(temp);
-	add_init(sum1, sum0, CirculateRight(temp));
+	sum0 = tempL;
+	add_init(sum1, sum0, tempR);
 
 	add(sum1, sum0, bU0);
 	add_init(sum2, sum1, bU1);
@@ -486,19 +1054,331 @@ uint64_t inline evolve(const uint64_t& temp, const uint64_t& bU0, const uint64_t
 	return ~sum2 & sum1 & (temp | sum0);
 }
 
-void LifeState::iterate()
+uint64_t inline evolve(const uint64_t& temp, const uint64_t& bU0, const uint64_t& bU1, const uint64_t& bB0, const uint64_t& bB1)
 {
-	uint64_t* state = this->state;
-	int min = this->min;
-	int max = this->max;
-	bool wrap = (min < 2) || (max > 64 - 3);
+	return evolve(temp, CirculateLeft(temp), CirculateRight(temp), bU0, bU1, bB0, bB1);
+}
 
+bool ParseRule(const char* rule, unsigned& birth, unsigned& survival)
+{
+	unsigned masks[2] = {0, 0};
+	int section = -1;
+	bool seen[2] = {false, false};
+	for (const char* ch = rule; *ch != '\0'; ch++)
+	{
+		char c = std::toupper((unsigned char)*ch);
+		if (c == 'B' || c == 'S')
+		{
+			section = (c == 'B') ? 0 : 1;
+			if (seen[section])
+			{
+				return false;
+			}
+			seen[section] = true;
+		}
+		else if (c == '/')
+		{
+			section = -1;
+		}
+		else if (section >= 0 && c >= '0' && c <= '8')
+		{
+			masks[section] |= 1u << (c - '0');
+		}
+		else
+		{
+			return false;
+		}
+	}
+	if (!seen[0] || !seen[1])
+	{
+		return false;
+	}
+	birth = masks[0];
+	survival = masks[1];
+	return true;
+}
+
+// Isotropic non-totalistic rules.
+
+// One representative of each Hensel class with 1 to 4 neighbours, as
+// IsotropicRule neighbour bits. The classes with 5 to 7 neighbours are
+// the complements of the classes with 3 to 1.
+static const struct { int count; char letter; int mask; } HenselClasses[] = {
+	{1, 'c', 0x02}, {1, 'e', 0x01},
+	{2, 'a', 0x03}, {2, 'c', 0x0A}, {2, 'e', 0x05}, {2, 'i', 0x11}, {2, 'k', 0x09}, {2, 'n', 0x22},
+	{3, 'a', 0x07}, {3, 'c', 0x2A}, {3, 'e', 0x15}, {3, 'i', 0x83}, {3, 'j', 0x43},
+	{3, 'k', 0x25}, {3, 'n', 0x0B}, {3, 'q', 0x23}, {3, 'r', 0x13}, {3, 'y', 0x29},
+	{4, 'a', 0x0F}, {4, 'c', 0xAA}, {4, 'e', 0x55}, {4, 'i', 0x1B}, {4, 'j', 0x53},
+	{4, 'k', 0x4B}, {4, 'n', 0x8B}, {4, 'q', 0x27}, {4, 'r', 0x17}, {4, 't', 0x93},
+	{4, 'w', 0x63}, {4, 'y', 0x2B}, {4, 'z', 0x33}
+};
+
+static const int HenselClassCount = sizeof(HenselClasses) / sizeof(HenselClasses[0]);
+
+// Quarter turn: N -> E -> S -> W.
+static inline int RotateNeighbours(int mask)
+{
+	return ((mask << 2) | (mask >> 6)) & 0xFF;
+}
+
+// Mirror in the N-S axis: neighbour k -> neighbour 8 - k.
+static inline int ReflectNeighbours(int mask)
+{
+	int result = 0;
+	for (int k = 0; k < 8; k++)
+	{
+		if (mask & (1 << k))
+		{
+			result |= 1 << ((8 - k) & 7);
+		}
+	}
+	return result;
+}
+
+// The Hensel letter of a set of neighbours, or 0 for 0 and 8 neighbours.
+static char HenselLetter(int mask)
+{
+	int count = __builtin_popcountll(mask);
+	if (count > 4)
+	{
+		mask = ~mask & 0xFF;
+		count = 8 - count;
+	}
+	for (int c = 0; c < HenselClassCount; c++)
+	{
+		if (HenselClasses[c].count != count)
+		{
+			continue;
+		}
+		int image = HenselClasses[c].mask;
+		for (int flip = 0; flip < 2; flip++)
+		{
+			for (int turn = 0; turn < 4; turn++)
+			{
+				if (image == mask)
+				{
+					return HenselClasses[c].letter;
+				}
+				image = RotateNeighbours(image);
+			}
+			image = ReflectNeighbours(image);
+		}
+	}
+	return 0;
+}
+
+static bool IsHenselLetter(int count, char letter)
+{
+	count = std::min(count, 8 - count);
+	for (int c = 0; c < HenselClassCount; c++)
+	{
+		if (HenselClasses[c].count == count && HenselClasses[c].letter == letter)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+IsotropicRule::IsotropicRule(const char* rule)
+{
+	this->valid = this->parse(rule);
+	if (!this->valid)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			this->table[i] = 0;
+		}
+	}
+	this->compile();
+}
+
+bool IsotropicRule::parse(const char* rule)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		this->table[i] = 0;
+	}
+	int section = -1;
+	bool seen[2] = {false, false};
+	const char* ch = rule;
+	while (*ch != '\0')
+	{
+		char c = std::toupper((unsigned char)*ch++);
+		if (c == 'B' || c == 'S')
+		{
+			section = (c == 'B') ? 0 : 1;
+			if (seen[section])
+			{
+				return false;
+			}
+			seen[section] = true;
+			continue;
+		}
+		if (c == '/')
+		{
+			section = -1;
+			continue;
+		}
+		if (section < 0 || c < '0' || c > '8')
+		{
+			return false;
+		}
+		// A count, then optionally '-' and the letters to include or exclude.
+		int count = c - '0';
+		bool negate = (*ch == '-');
+		if (negate)
+		{
+			ch++;
+		}
+		bool letters[26] = {false};
+		bool any = false;
+		while (*ch >= 'a' && *ch <= 'z' && *ch != 'b' && *ch != 's')
+		{
+			if (!IsHenselLetter(count, *ch))
+			{
+				return false;
+			}
+			letters[*ch - 'a'] = true;
+			any = true;
+			ch++;
+		}
+		if (negate && !any)
+		{
+			return false;
+		}
+		for (int mask = 0; mask < 256; mask++)
+		{
+			if (__builtin_popcountll(mask) != count)
+			{
+				continue;
+			}
+			if (any && letters[HenselLetter(mask) - 'a'] == negate)
+			{
+				continue;
+			}
+			int index = mask | (section ? CENTRE : 0);
+			this->table[index >> 6] |= 1ULL << (index & 63);
+		}
+	}
+	return seen[0] && seen[1];
+}
+
+// Build the reduced ordered BDD bottom-up: at level k each node is a slice
+// of 2^k table entries that splits on input k - 1, so the centre is the
+// root. Equal halves collapse and equal nodes are shared.
+void IsotropicRule::compile()
+{
+	this->gates.clear();
+	std::map<std::pair<int, std::pair<int, int> >, int> unique;
+	std::vector<int> level(512);
+	for (int i = 0; i < 512; i++)
+	{
+		level[i] = this->get(i) ? TRUE_REF : FALSE_REF;
+	}
+	for (int var = 0, size = 256; var < 9; var++, size /= 2)
+	{
+		for (int i = 0; i < size; i++)
+		{
+			int lo = level[2 * i];
+			int hi = level[2 * i + 1];
+			if (lo == hi)
+			{
+				level[i] = lo;
+				continue;
+			}
+			std::pair<int, std::pair<int, int> > key(var, std::make_pair(lo, hi));
+			std::map<std::pair<int, std::pair<int, int> >, int>::iterator it = unique.find(key);
+			if (it != unique.end())
+			{
+				level[i] = it->second;
+				continue;
+			}
+			Gate gate;
+			gate.var = var;
+			gate.lo = lo;
+			gate.hi = hi;
+			if (lo == FALSE_REF && hi == TRUE_REF)
+				gate.kind = GATE_VAR;
+			else if (lo == TRUE_REF && hi == FALSE_REF)
+				gate.kind = GATE_NOT;
+			else if (lo == FALSE_REF)
+				gate.kind = GATE_AND;
+			else if (hi == FALSE_REF)
+				gate.kind = GATE_ANDNOT;
+			else if (lo == TRUE_REF)
+				gate.kind = GATE_ORNOT;
+			else if (hi == TRUE_REF)
+				gate.kind = GATE_OR;
+			else
+				gate.kind = GATE_MUX;
+			level[i] = (int)this->gates.size();
+			unique[key] = level[i];
+			this->gates.push_back(gate);
+		}
+	}
+	assert((int)this->gates.size() <= MAX_GATES);
+	this->output = level[0];
+}
+
+// Gate-major evaluation: each gate runs over CHUNK rows at once, which
+// amortizes the dispatch and lets the compiler vectorize the row loops.
+void IsotropicRule::evaluate(const uint64_t* in, int count, uint64_t* out) const
+{
+	if (this->output < 0)
+	{
+		for (int r = 0; r < count; r++)
+		{
+			out[r] = (this->output == TRUE_REF) ? ~0ULL : 0ULL;
+		}
+		return;
+	}
+	uint64_t values[MAX_GATES * CHUNK];
+	for (size_t g = 0; g < this->gates.size(); g++)
+	{
+		const Gate& gate = this->gates[g];
+		const uint64_t* v = in + gate.var * CHUNK;
+		const uint64_t* lo = values + std::max(gate.lo, 0) * CHUNK;
+		const uint64_t* hi = values + std::max(gate.hi, 0) * CHUNK;
+		uint64_t* o = values + g * CHUNK;
+		switch (gate.kind)
+		{
+		case GATE_VAR:
+			for (int r = 0; r < CHUNK; r++) o[r] = v[r];
+			break;
+		case GATE_NOT:
+			for (int r = 0; r < CHUNK; r++) o[r] = ~v[r];
+			break;
+		case GATE_AND:
+			for (int r = 0; r < CHUNK; r++) o[r] = v[r] & hi[r];
+			break;
+		case GATE_ANDNOT:
+			for (int r = 0; r < CHUNK; r++) o[r] = ~v[r] & lo[r];
+			break;
+		case GATE_OR:
+			for (int r = 0; r < CHUNK; r++) o[r] = v[r] | lo[r];
+			break;
+		case GATE_ORNOT:
+			for (int r = 0; r < CHUNK; r++) o[r] = ~v[r] | hi[r];
+			break;
+		default:
+			for (int r = 0; r < CHUNK; r++) o[r] = lo[r] ^ (v[r] & (hi[r] ^ lo[r]));
+			break;
+		}
+	}
+	for (int r = 0; r < count; r++)
+	{
+		out[r] = values[this->output * CHUNK + r];
+	}
+}
+
+// Portable kernel. Relies on the compiler to vectorize the row loops.
+static void IterateScalar(uint64_t* state, int start, int last, bool wrap)
+{
 	uint64_t bit0[64] = {0};
 	uint64_t bit1[64] = {0};
-	
+
 	// Calculate indices
-	int start = wrap ? 0 : (min - 2);
-	int last = wrap ? (64 - 1) : (max + 2);
 	for (int i = start; i <= last; i++)
 	{
 		uint64_t l, m, r;
@@ -509,389 +1389,2889 @@ void LifeState::iterate()
 		bit1[i] = ((l | r) & m) | (l & r);
 	}
 
-	// Calculate tempState from state
-	uint64_t tempState[64];
-	for (int i = start+1; i <= last-1; i++)
-	{
-		tempState[i] = evolve(state[i], bit0[i - 1], bit1[i - 1], bit0[i + 1], bit1[i + 1]);
-	}
-	if (wrap)
+	// Calculate tempState from state
+	uint64_t tempState[64];
+	for (int i = start+1; i <= last-1; i++)
+	{
+		tempState[i] = evolve(state[i], bit0[i - 1], bit1[i - 1], bit0[i + 1], bit1[i + 1]);
+	}
+	if (wrap)
+	{
+		tempState[0] = evolve(state[0], bit0[64 - 1], bit1[64 - 1], bit0[1], bit1[1]);
+		tempState[64 - 1] = evolve(state[64 - 1], bit0[64 - 2], bit1[64 - 2], bit0[0], bit1[0]);
+	}
+
+	// Recalculate state from tempState
+	for (int i = start+1; i <= last-1; i++)
+	{
+		state[i] = tempState[i];
+	}
+	if (wrap)
+	{
+		state[0] = tempState[0];
+		state[64 - 1] = tempState[64 - 1];
+	}
+}
+
+// Hand-written x86 kernels. Each one is the same half-adder/full-adder
+// pipeline as add(), add_init() and evolve(), on 2, 4 or 8 rows at once.
+// The neighbour counts only depend on bit0/bit1, so the new rows can be
+// written straight back into state without a temporary copy.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define LIFE_HAVE_X86_KERNELS
+#ifdef _MSC_VER
+	#define LIFE_TARGET(isa)
+#else
+	#define LIFE_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+LIFE_TARGET("sse2")
+static void IterateSSE2(uint64_t* state, int start, int last, bool wrap)
+{
+	uint64_t bit0[64];
+	uint64_t bit1[64];
+	int i;
+
+	for (i = start; i + 1 <= last; i += 2)
+	{
+		__m128i m = _mm_loadu_si128((const __m128i*)(state + i));
+		__m128i l = _mm_or_si128(_mm_slli_epi64(m, 1), _mm_srli_epi64(m, 63));
+		__m128i r = _mm_or_si128(_mm_srli_epi64(m, 1), _mm_slli_epi64(m, 63));
+		__m128i b0 = _mm_xor_si128(_mm_xor_si128(l, r), m);
+		__m128i b1 = _mm_or_si128(_mm_and_si128(_mm_or_si128(l, r), m), _mm_and_si128(l, r));
+		_mm_storeu_si128((__m128i*)(bit0 + i), b0);
+		_mm_storeu_si128((__m128i*)(bit1 + i), b1);
+	}
+	for (; i <= last; i++)
+	{
+		uint64_t m = state[i];
+		uint64_t l = CirculateLeft(m);
+		uint64_t r = CirculateRight(m);
+		bit0[i] = l ^ r ^ m;
+		bit1[i] = ((l | r) & m) | (l & r);
+	}
+
+	uint64_t first = 0, final = 0;
+	if (wrap)
+	{
+		first = evolve(state[0], bit0[64 - 1], bit1[64 - 1], bit0[1], bit1[1]);
+		final = evolve(state[64 - 1], bit0[64 - 2], bit1[64 - 2], bit0[0], bit1[0]);
+	}
+	for (i = start + 1; i + 1 <= last - 1; i += 2)
+	{
+		__m128i temp = _mm_loadu_si128((const __m128i*)(state + i));
+		__m128i bU0 = _mm_loadu_si128((const __m128i*)(bit0 + i - 1));
+		__m128i bU1 = _mm_loadu_si128((const __m128i*)(bit1 + i - 1));
+		__m128i bB0 = _mm_loadu_si128((const __m128i*)(bit0 + i + 1));
+		__m128i bB1 = _mm_loadu_si128((const __m128i*)(bit1 + i + 1));
+		__m128i l = _mm_or_si128(_mm_slli_epi64(temp, 1), _mm_srli_epi64(temp, 63));
+		__m128i r = _mm_or_si128(_mm_srli_epi64(temp, 1), _mm_slli_epi64(temp, 63));
+		__m128i sum0, sum1, sum2, t;
+		sum1 = _mm_and_si128(l, r);
+		sum0 = _mm_xor_si128(l, r);
+		sum1 = _mm_or_si128(sum1, _mm_and_si128(sum0, bU0));
+		sum0 = _mm_xor_si128(sum0, bU0);
+		sum2 = _mm_and_si128(sum1, bU1);
+		sum1 = _mm_xor_si128(sum1, bU1);
+		t = _mm_and_si128(sum0, bB0);
+		sum2 = _mm_or_si128(sum2, _mm_and_si128(t, sum1));
+		sum1 = _mm_xor_si128(sum1, t);
+		sum0 = _mm_xor_si128(sum0, bB0);
+		sum2 = _mm_or_si128(sum2, _mm_and_si128(sum1, bB1));
+		sum1 = _mm_xor_si128(sum1, bB1);
+		__m128i result = _mm_andnot_si128(sum2, _mm_and_si128(sum1, _mm_or_si128(temp, sum0)));
+		_mm_storeu_si128((__m128i*)(state + i), result);
+	}
+	for (; i <= last - 1; i++)
+	{
+		state[i] = evolve(state[i], bit0[i - 1], bit1[i - 1], bit0[i + 1], bit1[i + 1]);
+	}
+	if (wrap)
+	{
+		state[0] = first;
+		state[64 - 1] = final;
+	}
+}
+
+LIFE_TARGET("avx2")
+static void IterateAVX2(uint64_t* state, int start, int last, bool wrap)
+{
+	uint64_t bit0[64];
+	uint64_t bit1[64];
+	int i;
+
+	for (i = start; i + 3 <= last; i += 4)
+	{
+		__m256i m = _mm256_loadu_si256((const __m256i*)(state + i));
+		__m256i l = _mm256_or_si256(_mm256_slli_epi64(m, 1), _mm256_srli_epi64(m, 63));
+		__m256i r = _mm256_or_si256(_mm256_srli_epi64(m, 1), _mm256_slli_epi64(m, 63));
+		__m256i b0 = _mm256_xor_si256(_mm256_xor_si256(l, r), m);
+		__m256i b1 = _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(l, r), m), _mm256_and_si256(l, r));
+		_mm256_storeu_si256((__m256i*)(bit0 + i), b0);
+		_mm256_storeu_si256((__m256i*)(bit1 + i), b1);
+	}
+	for (; i <= last; i++)
+	{
+		uint64_t m = state[i];
+		uint64_t l = CirculateLeft(m);
+		uint64_t r = CirculateRight(m);
+		bit0[i] = l ^ r ^ m;
+		bit1[i] = ((l | r) & m) | (l & r);
+	}
+
+	uint64_t first = 0, final = 0;
+	if (wrap)
+	{
+		first = evolve(state[0], bit0[64 - 1], bit1[64 - 1], bit0[1], bit1[1]);
+		final = evolve(state[64 - 1], bit0[64 - 2], bit1[64 - 2], bit0[0], bit1[0]);
+	}
+	for (i = start + 1; i + 3 <= last - 1; i += 4)
+	{
+		__m256i temp = _mm256_loadu_si256((const __m256i*)(state + i));
+		__m256i bU0 = _mm256_loadu_si256((const __m256i*)(bit0 + i - 1));
+		__m256i bU1 = _mm256_loadu_si256((const __m256i*)(bit1 + i - 1));
+		__m256i bB0 = _mm256_loadu_si256((const __m256i*)(bit0 + i + 1));
+		__m256i bB1 = _mm256_loadu_si256((const __m256i*)(bit1 + i + 1));
+		__m256i l = _mm256_or_si256(_mm256_slli_epi64(temp, 1), _mm256_srli_epi64(temp, 63));
+		__m256i r = _mm256_or_si256(_mm256_srli_epi64(temp, 1), _mm256_slli_epi64(temp, 63));
+		__m256i sum0, sum1, sum2, t;
+		sum1 = _mm256_and_si256(l, r);
+		sum0 = _mm256_xor_si256(l, r);
+		sum1 = _mm256_or_si256(sum1, _mm256_and_si256(sum0, bU0));
+		sum0 = _mm256_xor_si256(sum0, bU0);
+		sum2 = _mm256_and_si256(sum1, bU1);
+		sum1 = _mm256_xor_si256(sum1, bU1);
+		t = _mm256_and_si256(sum0, bB0);
+		sum2 = _mm256_or_si256(sum2, _mm256_and_si256(t, sum1));
+		sum1 = _mm256_xor_si256(sum1, t);
+		sum0 = _mm256_xor_si256(sum0, bB0);
+		sum2 = _mm256_or_si256(sum2, _mm256_and_si256(sum1, bB1));
+		sum1 = _mm256_xor_si256(sum1, bB1);
+		__m256i result = _mm256_andnot_si256(sum2, _mm256_and_si256(sum1, _mm256_or_si256(temp, sum0)));
+		_mm256_storeu_si256((__m256i*)(state + i), result);
+	}
+	for (; i <= last - 1; i++)
+	{
+		state[i] = evolve(state[i], bit0[i - 1], bit1[i - 1], bit0[i + 1], bit1[i + 1]);
+	}
+	if (wrap)
+	{
+		state[0] = first;
+		state[64 - 1] = final;
+	}
+}
+
+// AVX-512 has a native rotate, and vpternlogq merges the three-input
+// steps (bit0, bit1 and the final mask) into single instructions.
+// The maskz_ rotates avoid GCC's uninitialized-value warning on the
+// unmasked forms; the all-ones mask makes them plain rotates.
+LIFE_TARGET("avx512f")
+static void IterateAVX512(uint64_t* state, int start, int last, bool wrap)
+{
+	uint64_t bit0[64];
+	uint64_t bit1[64];
+	int i;
+
+	for (i = start; i + 7 <= last; i += 8)
+	{
+		__m512i m = _mm512_loadu_si512((const void*)(state + i));
+		__m512i l = _mm512_maskz_rol_epi64(0xFF, m, 1);
+		__m512i r = _mm512_maskz_ror_epi64(0xFF, m, 1);
+		// 0x96: l ^ r ^ m, 0xE8: majority(l, r, m).
+		_mm512_storeu_si512((void*)(bit0 + i), _mm512_ternarylogic_epi64(l, r, m, 0x96));
+		_mm512_storeu_si512((void*)(bit1 + i), _mm512_ternarylogic_epi64(l, r, m, 0xE8));
+	}
+	for (; i <= last; i++)
+	{
+		uint64_t m = state[i];
+		uint64_t l = CirculateLeft(m);
+		uint64_t r = CirculateRight(m);
+		bit0[i] = l ^ r ^ m;
+		bit1[i] = ((l | r) & m) | (l & r);
+	}
+
+	uint64_t first = 0, final = 0;
+	if (wrap)
+	{
+		first = evolve(state[0], bit0[64 - 1], bit1[64 - 1], bit0[1], bit1[1]);
+		final = evolve(state[64 - 1], bit0[64 - 2], bit1[64 - 2], bit0[0], bit1[0]);
+	}
+	for (i = start + 1; i + 7 <= last - 1; i += 8)
+	{
+		__m512i temp = _mm512_loadu_si512((const void*)(state + i));
+		__m512i bU0 = _mm512_loadu_si512((const void*)(bit0 + i - 1));
+		__m512i bU1 = _mm512_loadu_si512((const void*)(bit1 + i - 1));
+		__m512i bB0 = _mm512_loadu_si512((const void*)(bit0 + i + 1));
+		__m512i bB1 = _mm512_loadu_si512((const void*)(bit1 + i + 1));
+		__m512i l = _mm512_maskz_rol_epi64(0xFF, temp, 1);
+		__m512i r = _mm512_maskz_ror_epi64(0xFF, temp, 1);
+		__m512i sum0, sum1, sum2, t;
+		sum1 = _mm512_and_si512(l, r);
+		sum0 = _mm512_xor_si512(l, r);
+		sum1 = _mm512_or_si512(sum1, _mm512_and_si512(sum0, bU0));
+		sum0 = _mm512_xor_si512(sum0, bU0);
+		sum2 = _mm512_and_si512(sum1, bU1);
+		sum1 = _mm512_xor_si512(sum1, bU1);
+		t = _mm512_and_si512(sum0, bB0);
+		sum2 = _mm512_or_si512(sum2, _mm512_and_si512(t, sum1));
+		sum1 = _mm512_xor_si512(sum1, t);
+		sum0 = _mm512_xor_si512(sum0, bB0);
+		sum2 = _mm512_or_si512(sum2, _mm512_and_si512(sum1, bB1));
+		sum1 = _mm512_xor_si512(sum1, bB1);
+		// 0x40: sum1 & alive & ~sum2.
+		__m512i alive = _mm512_or_si512(temp, sum0);
+		__m512i result = _mm512_ternarylogic_epi64(sum1, alive, sum2, 0x40);
+		_mm512_storeu_si512((void*)(state + i), result);
+	}
+	for (; i <= last - 1; i++)
+	{
+		state[i] = evolve(state[i], bit0[i - 1], bit1[i - 1], bit0[i + 1], bit1[i + 1]);
+	}
+	if (wrap)
+	{
+		state[0] = first;
+		state[64 - 1] = final;
+	}
+}
+
+// Fused kernels: `gens` generations of the whole torus with the rows held
+// in registers (16 ymm or 8 zmm), so bit0/bit1 and the intermediate
+// generations never go through memory. The rows above and below come
+// from the neighbouring registers, wrapping around at the ends.
+LIFE_TARGET("avx2")
+static inline __m256i EvolveAVX2(__m256i temp, __m256i bU0, __m256i bU1, __m256i bB0, __m256i bB1)
+{
+	__m256i l = _mm256_or_si256(_mm256_slli_epi64(temp, 1), _mm256_srli_epi64(temp, 63));
+	__m256i r = _mm256_or_si256(_mm256_srli_epi64(temp, 1), _mm256_slli_epi64(temp, 63));
+	__m256i sum0, sum1, sum2, t;
+	sum1 = _mm256_and_si256(l, r);
+	sum0 = _mm256_xor_si256(l, r);
+	sum1 = _mm256_or_si256(sum1, _mm256_and_si256(sum0, bU0));
+	sum0 = _mm256_xor_si256(sum0, bU0);
+	sum2 = _mm256_and_si256(sum1, bU1);
+	sum1 = _mm256_xor_si256(sum1, bU1);
+	t = _mm256_and_si256(sum0, bB0);
+	sum2 = _mm256_or_si256(sum2, _mm256_and_si256(t, sum1));
+	sum1 = _mm256_xor_si256(sum1, t);
+	sum0 = _mm256_xor_si256(sum0, bB0);
+	sum2 = _mm256_or_si256(sum2, _mm256_and_si256(sum1, bB1));
+	sum1 = _mm256_xor_si256(sum1, bB1);
+	return _mm256_andnot_si256(sum2, _mm256_and_si256(sum1, _mm256_or_si256(temp, sum0)));
+}
+
+// Rows i - 1 of `cur`: {prev[3], cur[0], cur[1], cur[2]}.
+LIFE_TARGET("avx2")
+static inline __m256i RowsAboveAVX2(__m256i prev, __m256i cur)
+{
+	return _mm256_alignr_epi8(cur, _mm256_permute2x128_si256(prev, cur, 0x21), 8);
+}
+
+// Rows i + 1 of `cur`: {cur[1], cur[2], cur[3], next[0]}.
+LIFE_TARGET("avx2")
+static inline __m256i RowsBelowAVX2(__m256i cur, __m256i next)
+{
+	return _mm256_alignr_epi8(_mm256_permute2x128_si256(cur, next, 0x21), cur, 8);
+}
+
+LIFE_TARGET("avx2")
+static void IterateFusedAVX2(uint64_t* state, int gens)
+{
+	__m256i v[16];
+	__m256i b0[16];
+	__m256i b1[16];
+	for (int j = 0; j < 16; j++)
+	{
+		v[j] = _mm256_loadu_si256((const __m256i*)(state + 4 * j));
+	}
+	for (int g = 0; g < gens; g++)
+	{
+		for (int j = 0; j < 16; j++)
+		{
+			__m256i l = _mm256_or_si256(_mm256_slli_epi64(v[j], 1), _mm256_srli_epi64(v[j], 63));
+			__m256i r = _mm256_or_si256(_mm256_srli_epi64(v[j], 1), _mm256_slli_epi64(v[j], 63));
+			b0[j] = _mm256_xor_si256(_mm256_xor_si256(l, r), v[j]);
+			b1[j] = _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(l, r), v[j]), _mm256_and_si256(l, r));
+		}
+		for (int j = 0; j < 16; j++)
+		{
+			int up = (j + 16 - 1) & 15;
+			int down = (j + 1) & 15;
+			v[j] = EvolveAVX2(v[j],
+				RowsAboveAVX2(b0[up], b0[j]), RowsAboveAVX2(b1[up], b1[j]),
+				RowsBelowAVX2(b0[j], b0[down]), RowsBelowAVX2(b1[j], b1[down]));
+		}
+	}
+	for (int j = 0; j < 16; j++)
+	{
+		_mm256_storeu_si256((__m256i*)(state + 4 * j), v[j]);
+	}
+}
+
+LIFE_TARGET("avx512f")
+static void IterateFusedAVX512(uint64_t* state, int gens)
+{
+	__m512i v[8];
+	__m512i b0[8];
+	__m512i b1[8];
+	for (int j = 0; j < 8; j++)
+	{
+		v[j] = _mm512_loadu_si512((const void*)(state + 8 * j));
+	}
+	for (int g = 0; g < gens; g++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			__m512i l = _mm512_maskz_rol_epi64(0xFF, v[j], 1);
+			__m512i r = _mm512_maskz_ror_epi64(0xFF, v[j], 1);
+			b0[j] = _mm512_ternarylogic_epi64(l, r, v[j], 0x96);
+			b1[j] = _mm512_ternarylogic_epi64(l, r, v[j], 0xE8);
+		}
+		for (int j = 0; j < 8; j++)
+		{
+			int up = (j + 8 - 1) & 7;
+			int down = (j + 1) & 7;
+			// valignq: {up[7], cur[0..6]} and {cur[1..7], down[0]}.
+			__m512i bU0 = _mm512_maskz_alignr_epi64(0xFF, b0[j], b0[up], 7);
+			__m512i bU1 = _mm512_maskz_alignr_epi64(0xFF, b1[j], b1[up], 7);
+			__m512i bB0 = _mm512_maskz_alignr_epi64(0xFF, b0[down], b0[j], 1);
+			__m512i bB1 = _mm512_maskz_alignr_epi64(0xFF, b1[down], b1[j], 1);
+			__m512i temp = v[j];
+			__m512i l = _mm512_maskz_rol_epi64(0xFF, temp, 1);
+			__m512i r = _mm512_maskz_ror_epi64(0xFF, temp, 1);
+			__m512i sum0, sum1, sum2, t;
+			sum1 = _mm512_and_si512(l, r);
+			sum0 = _mm512_xor_si512(l, r);
+			sum1 = _mm512_or_si512(sum1, _mm512_and_si512(sum0, bU0));
+			sum0 = _mm512_xor_si512(sum0, bU0);
+			sum2 = _mm512_and_si512(sum1, bU1);
+			sum1 = _mm512_xor_si512(sum1, bU1);
+			t = _mm512_and_si512(sum0, bB0);
+			sum2 = _mm512_or_si512(sum2, _mm512_and_si512(t, sum1));
+			sum1 = _mm512_xor_si512(sum1, t);
+			sum0 = _mm512_xor_si512(sum0, bB0);
+			sum2 = _mm512_or_si512(sum2, _mm512_and_si512(sum1, bB1));
+			sum1 = _mm512_xor_si512(sum1, bB1);
+			v[j] = _mm512_ternarylogic_epi64(sum1, _mm512_or_si512(temp, sum0), sum2, 0x40);
+		}
+	}
+	for (int j = 0; j < 8; j++)
+	{
+		_mm512_storeu_si512((void*)(state + 8 * j), v[j]);
+	}
+}
+#endif
+
+typedef void (*IterateKernel)(uint64_t* state, int start, int last, bool wrap);
+typedef void (*FusedKernel)(uint64_t* state, int gens);
+
+static bool CpuSupports(SimdLevel level)
+{
+#ifdef LIFE_HAVE_X86_KERNELS
+	#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	__cpuidex(info, 7, 0);
+	bool avx2 = osxsave && ((xcr0 & 0x06) == 0x06) && (info[1] & (1 << 5)) != 0;
+	bool avx512 = osxsave && ((xcr0 & 0xE6) == 0xE6) && (info[1] & (1 << 16)) != 0;
+	#else
+	__builtin_cpu_init();
+	bool sse2 = __builtin_cpu_supports("sse2");
+	bool avx2 = __builtin_cpu_supports("avx2");
+	bool avx512 = __builtin_cpu_supports("avx512f");
+	#endif
+	switch (level)
+	{
+		case SIMD_NONE: return true;
+		case SIMD_SSE2: return sse2;
+		case SIMD_AVX2: return avx2;
+		case SIMD_AVX512: return avx512;
+	}
+	return false;
+#else
+	return level == SIMD_NONE;
+#endif
+}
+
+static IterateKernel KernelFor(SimdLevel level)
+{
+	switch (level)
+	{
+#ifdef LIFE_HAVE_X86_KERNELS
+		case SIMD_SSE2: return IterateSSE2;
+		case SIMD_AVX2: return IterateAVX2;
+		case SIMD_AVX512: return IterateAVX512;
+#endif
+		default: return IterateScalar;
+	}
+}
+
+// NULL where the whole torus doesn't fit in registers: stepping all 64
+// rows in memory would lose to the bounded iterate().
+static FusedKernel FusedKernelFor(SimdLevel level)
+{
+	switch (level)
+	{
+#ifdef LIFE_HAVE_X86_KERNELS
+		case SIMD_AVX2: return IterateFusedAVX2;
+		case SIMD_AVX512: return IterateFusedAVX512;
+#endif
+		default: return NULL;
+	}
+}
+
+static void IterateResolve(uint64_t* state, int start, int last, bool wrap);
+
+// All three are constant-initialized, so iterate() is safe to call from
+// other translation units' static initializers. Under C++11 they are
+// atomic, so threads that evolve their first states at the same time can
+// all resolve them: they store the same values, the kernel pointer last.
+// Before C++11, call getSimdLevel() once before starting threads.
+#if __cplusplus >= 201103L
+static std::atomic<IterateKernel> iterateKernel(IterateResolve);
+static std::atomic<FusedKernel> fusedKernel(NULL);
+static std::atomic<SimdLevel> iterateLevel(SIMD_NONE);
+#else
+static IterateKernel iterateKernel = IterateResolve;
+static FusedKernel fusedKernel = NULL;
+static SimdLevel iterateLevel = SIMD_NONE;
+#endif
+
+static void IterateResolve(uint64_t* state, int start, int last, bool wrap)
+{
+	LifeState::getSimdLevel();
+	IterateKernel kernel = iterateKernel;
+	kernel(state, start, last, wrap);
+}
+
+SimdLevel LifeState::getSimdLevel()
+{
+	if (iterateKernel == IterateResolve)
+	{
+		SimdLevel best = SIMD_NONE;
+		if (CpuSupports(SIMD_SSE2)) best = SIMD_SSE2;
+		if (CpuSupports(SIMD_AVX2)) best = SIMD_AVX2;
+		if (CpuSupports(SIMD_AVX512)) best = SIMD_AVX512;
+		iterateLevel = best;
+		fusedKernel = FusedKernelFor(best);
+		iterateKernel = KernelFor(best);
+	}
+	return iterateLevel;
+}
+
+bool LifeState::setSimdLevel(SimdLevel level)
+{
+	if (!CpuSupports(level))
+	{
+		return false;
+	}
+	iterateLevel = level;
+	fusedKernel = FusedKernelFor(level);
+	iterateKernel = KernelFor(level);
+	return true;
+}
+
+void LifeState::iterate()
+{
+	IterateKernel kernel = iterateKernel;
+	this->iterate(kernel, false);
+}
+
+// Only rows next to a live row can change. If they fit in a span that
+// misses rows 0 and 63, the kernel runs on it in place; if the span
+// crosses the seam, it runs on a contiguous copy of the span.
+void LifeState::iterate(RowKernel kernel, bool full)
+{
+	uint64_t* state = this->state;
+	int start = 0;
+	int length = 64;
+	if(!full)
+	{
+		uint64_t active = this->rows | CirculateLeft(this->rows) | CirculateRight(this->rows);
+		CircularSpan(active, start, length);
+	}
+
+	if(length >= 64 - 1)
+	{
+		kernel(state, 0, 64 - 1, true);
+		this->recalculateBounds();
+	}
+	else if(length > 0 && start >= 1 && start + length <= 64 - 1)
+	{
+		kernel(state, start - 1, start + length, false);
+		this->refitBounds(start, length);
+	}
+	else if(length > 0)
+	{
+		uint64_t temp[64];
+		for(int k = 0; k <= length + 1; k++)
+		{
+			temp[k] = state[(start - 1 + k) & 63];
+		}
+		kernel(temp, 0, length + 1, false);
+		for(int k = 1; k <= length; k++)
+		{
+			state[(start - 1 + k) & 63] = temp[k];
+		}
+		this->refitBounds(start, length);
+	}
+	this->gen++;
+}
+
+// Generations the pattern needs to get a live cell near row 0: every
+// glider removeGliders() finds has a cell in row 0. The count stops two
+// rows short on the far side, so it errs on the early side.
+static int GensToEdge(int start, int length)
+{
+	if(start < 1 || start + length - 1 > 64 - 3)
+	{
+		return 0;
+	}
+	return std::min(start, 64 - 2 - (start + length - 1));
+}
+
+// Generations before a live cell can get within `margin` of the edge,
+// where removeSpaceships() looks.
+static int GensToBand(int start, int length, int margin)
+{
+	if(start <= margin || start + length - 1 >= 64 - margin)
+	{
+		return 0;
+	}
+	return std::min(start - margin, 64 - margin - (start + length - 1));
+}
+
+// Between glider checks the generations go through the fused kernel with
+// no bookkeeping in between. With GLIDERS_EVERY_GEN that's while the
+// pattern is too far from the edge for a check to find anything.
+void LifeState::run(int gens)
+{
+	assert(gens > 0);
+	for(int i=0; i<gens; )
+	{
+		int start, length;
+		CircularSpan(this->rows, start, length);
+		if(length == 0)
+		{
+			this->gen += gens - i;
+			return;
+		}
+		int fused = gens - i;
+		if(this->gliderRemoval == GLIDERS_EVERY_GEN)
+		{
+			fused = std::min(fused, GensToEdge(start, length) - 1);
+		}
+		else if(this->gliderRemoval == GLIDERS_PERIODIC)
+		{
+			fused = std::min(fused, this->gliderPeriod - this->gen % this->gliderPeriod);
+		}
+		if(this->catalog != NULL)
+		{
+			int cstart, clength;
+			CircularSpan(this->cols, cstart, clength);
+			int margin = 2 * this->catalog->getBand() + 1;
+			fused = std::min(fused, GensToBand(start, length, margin) - 1);
+			fused = std::min(fused, GensToBand(cstart, clength, margin) - 1);
+		}
+		if(fused >= 2)
+		{
+			this->iterateFused(fused);
+		}
+		else
+		{
+			fused = 1;
+			this->iterate();
+		}
+		i += fused;
+
+		if(this->gliderRemoval == GLIDERS_EVERY_GEN)
+		{
+			this->removeGliders();
+		}
+		else if(this->gliderRemoval == GLIDERS_PERIODIC && this->gen % this->gliderPeriod == 0)
+		{
+			// A glider moves a cell every 4 generations, so it can't get
+			// through a band this wide between two checks.
+			this->removeGlidersInBand(this->gliderPeriod / 4 + 2);
+		}
+		if(this->catalog != NULL)
+		{
+			this->removeSpaceships(*this->catalog);
+		}
+	}
+}
+
+// The last maxPeriod generations are kept in a ring with their
+// translation-invariant hashes and the starts those were taken from. A
+// matching hash is only a candidate: the old state is moved by the shift
+// between the starts and compared word by word.
+StabilityData LifeState::runUntilStable(int maxGens, int maxPeriod)
+{
+	assert(maxPeriod > 0);
+	StabilityData result = {false, -1, 0, 0, 0};
+	std::vector<LifeState> states(maxPeriod);
+	std::vector<uint64_t> hashes(maxPeriod);
+	std::vector<int> starts(2 * maxPeriod);
+	uint64_t hi;
+	states[0] = *this;
+	this->getNormalHash(hashes[0], hi, starts[0], starts[1]);
+	for(int step = 1; step <= maxGens; step++)
+	{
+		this->run(1);
+		uint64_t hash;
+		int x, y;
+		this->getNormalHash(hash, hi, x, y);
+		for(int period = 1; period <= std::min(step, maxPeriod); period++)
+		{
+			int k = (step - period) % maxPeriod;
+			if(hashes[k] != hash)
+			{
+				continue;
+			}
+			int dx = ((x - starts[2 * k] + 96) & 63) - 32;
+			int dy = ((y - starts[2 * k + 1] + 96) & 63) - 32;
+			if(states[k].transform(dx, dy) == *this)
+			{
+				result.stable = true;
+				result.gen = this->gen - period;
+				result.period = period;
+				result.dx = dx;
+				result.dy = dy;
+				return result;
+			}
+		}
+		int k = step % maxPeriod;
+		states[k] = *this;
+		hashes[k] = hash;
+		starts[2 * k] = x;
+		starts[2 * k + 1] = y;
+	}
+	return result;
+}
+
+void LifeState::setGliderRemoval(GliderRemoval mode, int period)
+{
+	assert(period > 0);
+	this->gliderRemoval = mode;
+	this->gliderPeriod = (mode == GLIDERS_PERIODIC) ? period : 1;
+}
+
+// The fused kernels step the whole torus. Below AVX-512 that costs more
+// than bounded generations once the pattern spans fewer rows, so such a
+// pattern goes a generation at a time instead.
+// Whole-torus register steps where there's a kernel for them and the
+// pattern spans most of the rows; otherwise bounded iterate() steps.
+void LifeState::iterateFused(int gens)
+{
+	SimdLevel level = LifeState::getSimdLevel();
+	FusedKernel kernel = fusedKernel;
+	bool bounded = (kernel == NULL);
+	if(!bounded && level < SIMD_AVX512)
+	{
+		int start, length;
+		CircularSpan(this->rows, start, length);
+		bounded = (length < 64 - 16);
+	}
+	if(bounded)
+	{
+		for(int g = 0; g < gens; g++)
+		{
+			this->iterate();
+		}
+		return;
+	}
+	kernel(this->state, gens);
+	this->recalculateBounds();
+	this->gen += gens;
+}
+
+LifeState LifeState::after(int gens) const
+{
+	LifeState result(*this);
+	result.run(gens);
+	return result;
+}
+
+void LifeState::iterate(const IsotropicRule& rule)
+{
+	const int CHUNK = IsotropicRule::CHUNK;
+	uint64_t* state = this->state;
+	// With B0 the empty rows outside the bounds come alive too.
+	int start = 0;
+	int length = 64;
+	if (!rule.hasB0())
+	{
+		uint64_t active = this->rows | CirculateLeft(this->rows) | CirculateRight(this->rows);
+		CircularSpan(active, start, length);
+	}
+
+	uint64_t next[64];
+	uint64_t in[9 * CHUNK] = {0};
+	for (int k = 0; k < length; k += CHUNK)
+	{
+		int count = std::min(CHUNK, length - k);
+		for (int r = 0; r < count; r++)
+		{
+			// Row i is column x; the rows either side are x - 1 and x + 1.
+			int i = (start + k + r) & 63;
+			uint64_t w = state[(i + 64 - 1) & 63];
+			uint64_t m = state[i];
+			uint64_t e = state[(i + 1) & 63];
+			in[0 * CHUNK + r] = CirculateLeft(m);  // N
+			in[1 * CHUNK + r] = CirculateLeft(e);  // NE
+			in[2 * CHUNK + r] = e;                 // E
+			in[3 * CHUNK + r] = CirculateRight(e); // SE
+			in[4 * CHUNK + r] = CirculateRight(m); // S
+			in[5 * CHUNK + r] = CirculateRight(w); // SW
+			in[6 * CHUNK + r] = w;                 // W
+			in[7 * CHUNK + r] = CirculateLeft(w);  // NW
+			in[8 * CHUNK + r] = m;                 // Centre
+		}
+		rule.evaluate(in, count, next + k);
+	}
+	for (int k = 0; k < length; k++)
+	{
+		state[(start + k) & 63] = next[k];
+	}
+
+	this->refitBounds(start, length);
+	this->gen++;
+}
+
+void LifeState::run(const IsotropicRule& rule, int gens)
+{
+	for (int i = 0; i < gens; i++)
+	{
+		this->iterate(rule);
+	}
+}
+
+LifeState LifeState::after(const IsotropicRule& rule, int gens) const
+{
+	LifeState result(*this);
+	result.run(rule, gens);
+	return result;
+}
+
+// To other objects.
+
+std::string LifeState::toDebugString() const
+{
+	std::stringstream ss;
+	int i, j;
+
+	for(i = 0; i < 64; i++)
+	{
+		for(j = 0; j < 64; j++)
+		{
+			char ch;
+			if(this->getCell(j - 32, i - 32) == 0)
+			{
+				bool hor = ((i - 32) % 10 == 0);
+				bool ver = ((j - 32) % 10 == 0);
+				if(hor && ver)  ch = '+';
+				else if(hor) ch = '-';
+				else if(ver) ch = '|';
+				else ch = '.';
+			} else {
+				ch = 'O';
+			}
+			ss << ch;
+		}
+		ss << '\n';
+	}
+	ss << '\n';
+	return ss.str();
+}
+
+void RLEWriter::cell(int val)
+{
+	// Flush linefeeds if we find a live cell
+	if(val == 1 && this->eolCount > 0)
+	{
+		if(this->eolCount > 1)
+		{
+			this->ss << this->eolCount;
+		}
+		this->ss << '$';
+		this->eolCount = 0;
+	}
+
+	// Flush current run if val changes
+	if (val != this->lastVal)
+	{
+		if(this->runCount > 1)
+		{
+			this->ss << this->runCount;
+		}
+		// N.B. lastVal can be -1.
+		// Using boolean value of lastVal is unreliable.
+		if (this->lastVal == 1)
+		{
+			this->ss << 'o';
+		}
+		else if (this->lastVal == 0)
+		{
+			this->ss << 'b';
+		}
+		this->runCount = 0;
+	}
+	this->runCount++;
+	this->lastVal = val;
+}
+
+void RLEWriter::endRow()
+{
+	// Flush run of live cells at end of line
+	if (this->lastVal == 1)
+	{
+		if(this->runCount > 1)
+		{
+			this->ss << this->runCount;
+		}
+		this->ss << 'o';
+	}
+	this->lastVal = -1;
+	this->runCount = 0;
+	this->eolCount++;
+}
+
+std::string RLEWriter::finish()
+{
+	// Flush remaining linefeeds to make the full height.
+	if (this->eolCount > 0) 
+	{
+		if (this->eolCount > 1)
+		{
+			this->ss << this->eolCount;
+		}
+		this->ss << '$';
+	}
+	return this->ss.str();
+}
+
+std::string LifeState::toRLE() const
+{
+	RLEWriter writer;
+	// Cells past the last live row never get written out.
+	int width = (this->rows == 0) ? 0 : HighestBit(this->rows) + 1;
+
+	for(int j = 0; j < 64; j++)
+	{
+		if(((this->cols >> j) & 1) != 0)
+		{
+			for(int i = 0; i < width; i++)
+			{
+				writer.cell(Get(this->state, i, j));
+			}
+		}
+		writer.endRow();
+	}
+	return writer.finish();
+}
+
+// CellList and LifeLocator related features.
+
+struct CellAppender
+{
+	CellList* cells;
+	void operator()(int x, int y) const
+	{
+		Cell c = {x, y};
+		this->cells->push_back(c);
+	}
+};
+
+static bool LineOrder(const Cell& a, const Cell& b)
+{
+	return (a.y != b.y) ? (a.y < b.y) : (a.x < b.x);
+}
+
+// Line by line, left to right, as callers have always got them;
+// forEachCell() goes a column at a time.
+CellList LifeState::toCellList() const
+{
+	CellList clist;
+	clist.reserve(this->getPop());
+	CellAppender append = {&clist};
+	this->forEachCell(append);
+	std::sort(clist.begin(), clist.end(), LineOrder);
+	return clist;
+}
+
+LifeState CellList::toLifeState() const
+{
+	LifeState result;
+	for (CellList::const_iterator it=this->begin(); it != this->end(); ++it)
+	{
+		result.setCell(it->x, it->y, 1);
+	}
+	return result;
+}
+
+LifeLocator LifeState::toLifeLocator() const
+{
+	return LifeLocator(*this, LifeState());
+}
+
+LifeLocator::LifeLocator(const LifeLocator& rhs)
+{
+	this->on = rhs.on;
+	this->off = rhs.off;
+	this->rows = rhs.rows;
+	this->shifts = rhs.shifts;
+	this->compiledOn = rhs.compiledOn;
+	this->compiledOff = rhs.compiledOff;
+}
+
+LifeLocator::LifeLocator(const char* rle, int x, int y)
+{
+	this->on = LifeState(rle).transform(x, y).toCellList();
+	this->off.clear();
+	this->compile();
+}
+
+LifeLocator::LifeLocator(const char* rle, int x, int y, int dxx, int dxy, int dyx, int dyy)
+{
+	this->on = LifeState(rle).transform(x, y, dxx, dxy, dyx, dyy).toCellList();
+	this->off.clear();
+	this->compile();
+}
+
+LifeLocator::LifeLocator(const LifeState& on, const LifeState& off)
+{
+	this->on = on.toCellList();
+	this->off = off.toCellList();
+	this->compile();
+}
+
+// Cells are grouped by row offset, so each row is fetched once however
+// many of its cells are tested, with the offsets reduced mod 64 here
+// rather than per test.
+void LifeLocator::compile() const
+{
+	this->compiledOn = this->on;
+	this->compiledOff = this->off;
+	this->rows.clear();
+	this->shifts.clear();
+	for (int pass=0; pass<2; ++pass)
+	{
+		const CellList& cells = (pass == 0) ? this->on : this->off;
+		std::map<int, std::vector<int> > byRow;
+		for (CellList::const_iterator it = cells.begin(); it != cells.end(); ++it)
+		{
+			byRow[((it->x % 64) + 64) % 64].push_back(((it->y % 64) + 64) % 64);
+		}
+		for (std::map<int, std::vector<int> >::const_iterator it = byRow.begin(); it != byRow.end(); ++it)
+		{
+			Row row;
+			row.dx = it->first;
+			row.on = (pass == 0);
+			row.first = (int)this->shifts.size();
+			row.count = (int)it->second.size();
+			this->shifts.insert(this->shifts.end(), it->second.begin(), it->second.end());
+			this->rows.push_back(row);
+		}
+	}
+}
+
+static bool SameCells(const CellList& a, const CellList& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+	for (size_t n=0; n<a.size(); ++n)
+	{
+		if (a[n].x != b[n].x || a[n].y != b[n].y)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void LifeLocator::refresh() const
+{
+	if (!SameCells(this->on, this->compiledOn) || !SameCells(this->off, this->compiledOff))
+	{
+		this->compile();
+	}
+}
+
+// acc[j] holds the matches in row base + j so far. `columns` is the state
+// twice over, so the LANES rows at any offset are contiguous. Returns
+// false as soon as no lane has a match left.
+bool LifeLocator::matchLanes(const uint64_t* columns, int base, uint64_t* acc) const
+{
+	for (size_t r=0; r<this->rows.size(); ++r)
+	{
+		const Row& row = this->rows[r];
+		const uint64_t* words = columns + ((base + row.dx) & 63);
+		uint64_t flip = row.on ? 0 : ~0ULL;
+		uint64_t any = 0;
+		for (int j=0; j<LANES; ++j)
+		{
+			uint64_t word = words[j] ^ flip;
+			uint64_t a = acc[j];
+			for (int k=0; k<row.count; ++k)
+			{
+				a &= CirculateRight(word, this->shifts[row.first + k]);
+			}
+			acc[j] = a;
+			any |= a;
+		}
+		if (any == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+LifeLocator LifeLocator::withBoundary() const
+{
+	LifeLocator result(*this);
+	LifeState on = this->on.toLifeState();
+	LifeState off = on.dilate(-1, -1, 3, 3);
+	off &= (~on);
+	result.off = off.toCellList();
+	result.compile();
+	return result;
+}
+
+uint64_t LifeState::locateAtX(const CellList& target, int x, bool on) const
+{
+	uint64_t locations = ~0ULL;
+
+	for(CellList::const_iterator it = target.begin(); it != target.end(); ++it)
+	{
+		int idx = (x + 32 + it->x) % 64;
+		int circulate = (it->y) % 64;
+		// Make 'em positive.
+		idx += ((idx < 0) ? 64 : 0);
+		circulate += ((circulate < 0) ? 64 : 0);
+
+		if (on)
+		{
+			locations &= CirculateRight(this->state[idx], circulate);
+		}
+		else
+		{
+			locations &= CirculateRight(~(this->state[idx]), circulate);
+		}
+
+		if(locations == 0ULL)
+		{
+			break;
+		}
+	}
+
+	return locations;
+}
+
+uint64_t LifeState::locateAtX(const LifeLocator& l, int x) const
+{
+	// ON rows come first, so OFF cells are only checked where they match.
+	uint64_t locations = ~0ULL;
+	for (size_t r=0; r<l.rows.size() && locations != 0; ++r)
+	{
+		const LifeLocator::Row& row = l.rows[r];
+		uint64_t word = this->state[(x + 32 + row.dx) & 63];
+		if (!row.on)
+		{
+			word = ~word;
+		}
+		for (int k=0; k<row.count; ++k)
+		{
+			locations &= CirculateRight(word, l.shifts[row.first + k]);
+		}
+	}
+	return locations;
+}
+
+// add() for a counter of any width: `count` holds `planes` bit planes,
+// and `over` is set where the count has passed 2^planes - 1.
+static inline void add(uint64_t* count, int planes, uint64_t& over, uint64_t val)
+{
+	for (int b=0; b<planes && val != 0; ++b)
+	{
+		uint64_t carry = count[b] & val;
+		count[b] ^= val;
+		val = carry;
+	}
+	over |= val;
+}
+
+// Positions where the counter is at most k, compared from the top plane.
+static inline uint64_t AtMost(const uint64_t* count, int planes, uint64_t over, int k)
+{
+	uint64_t less = 0;
+	uint64_t equal = ~0ULL;
+	for (int b=planes-1; b>=0; --b)
+	{
+		if ((k >> b) & 1)
+		{
+			less |= equal & ~count[b];
+			equal &= count[b];
+		}
+		else
+		{
+			equal &= ~count[b];
+		}
+	}
+	return (less | equal) & ~over;
+}
+
+// Every cell of `l` adds its mismatches to a bit-sliced counter per
+// position, so all 64 positions of the row are counted at once.
+uint64_t LifeState::locateAtX(const LifeLocator& l, int x, int maxMismatches) const
+{
+	// No position can miss more cells than the locator has.
+	if (maxMismatches >= (int)(l.on.size() + l.off.size()))
+	{
+		return ~0ULL;
+	}
+	int planes = 1;
+	while ((1 << planes) <= maxMismatches)
+	{
+		planes++;
+	}
+	uint64_t count[32] = {0};
+	uint64_t over = 0;
+	for (size_t r=0; r<l.rows.size() && over != ~0ULL; ++r)
+	{
+		const LifeLocator::Row& row = l.rows[r];
+		uint64_t word = this->state[(x + 32 + row.dx) & 63];
+		if (row.on)
+		{
+			word = ~word;
+		}
+		for (int k=0; k<row.count; ++k)
+		{
+			add(count, planes, over, CirculateRight(word, l.shifts[row.first + k]));
+		}
+	}
+	return AtMost(count, planes, over, maxMismatches);
+}
+
+void LifeState::removeAtX(const CellList& target, int x, uint64_t locations)
+{
+	if(locations == 0ULL)
+	{
+		return;
+	}
+	//
+	for(CellList::const_iterator it = target.begin(); it != target.end(); ++it)
+	{
+		int idx = (x + 32 + it->x) % 64;
+		int circulate = (it->y) % 64;
+		idx += ((idx < 0) ? 64  : 0);
+		circulate += ((circulate < 0) ? 64 : 0);
+		this->state[idx] &= ~CirculateLeft(locations, circulate);
+	}
+}
+
+void LifeState::removeAtX(const LifeLocator& l, int x)
+{
+	uint64_t locations = this->locateAtX(l, x);
+	this->removeAtX(l.on, x, locations);
+}
+
+// Remove the gliders matching `l` at column x and record them. Directions
+// are 0: SE, 1: SW, 2: NW, 3: NE.
+bool LifeState::removeGlidersAt(const LifeLocator& l, int direction, int x)
+{
+	uint64_t locations = this->locateAtX(l, x);
+	if (locations == 0)
+	{
+		return false;
+	}
+	this->removeAtX(l.on, x, locations);
+	bool dx = (direction == 0 || direction == 3);
+	bool dy = (direction == 0 || direction == 1);
+	for (; locations != 0; locations &= locations - 1)
+	{
+		GliderData gd = {x, LowestBit(locations) - 32, this->gen, dx, dy};
+		this->logGlider(gd);
+	}
+	return true;
+}
+
+void LifeState::logGlider(const GliderData& gd)
+{
+	if (this->gliderCount < GLIDER_RECORDS)
+	{
+		this->gliders[this->gliderCount] = gd;
+	}
+	if (this->sink != NULL)
+	{
+		this->sink->gliders.push_back(gd);
+	}
+	this->gliderCount++;
+}
+
+void LifeState::logSpaceship(const SpaceshipData& data)
+{
+	if (this->spaceshipCount < SPACESHIP_RECORDS)
+	{
+		this->spaceships[this->spaceshipCount] = data;
+	}
+	if (this->sink != NULL)
+	{
+		this->sink->spaceships.push_back(data);
+	}
+	this->spaceshipCount++;
+}
+
+void LifeState::removeGliders()
+{
+	// Canonical gliders
+	static const LifeState glider("bo$2bo$3o!", -2, -2);
+	static const LifeLocator glider_locators[4] =
+	{
+		glider.toLifeLocator().withBoundary(), // SE
+		glider.transform(0, 0, 0, -1, 1, 0).toLifeLocator().withBoundary(), // SW
+		glider.transform(0, 0, -1, 0, 0, -1).toLifeLocator().withBoundary(), // NW
+		glider.transform(0, 0, 0, 1, -1, 0).toLifeLocator().withBoundary() // NE
+	};
+	// The SE and NE gliders reach back to rows 62 and 63 and the SW and NW
+	// ones on to rows 1 and 2, but all of them have an ON cell in row 0.
+	if ((this->rows & 1) == 0)
+	{
+		return;
+	}
+	bool removed = false;
+	for (int i=0; i<4; ++i)
+	{
+		removed = this->removeGlidersAt(glider_locators[i], i, -32) || removed;
+	}
+	if (removed)
+	{
+		this->refitBounds();
+	}
+}
+
+// Phases 0 to 3 of the SE, SW, NW and NE gliders, in that order.
+static std::vector<LifeLocator> MakePhaseLocators()
+{
+	std::vector<LifeLocator> locators;
+	LifeState glider("bo$2bo$3o!", -2, -2);
+	static const int matrices[4][4] = {{1, 0, 0, 1}, {0, -1, 1, 0}, {-1, 0, 0, -1}, {0, 1, -1, 0}};
+	for (int i=0; i<4; ++i)
+	{
+		const int* m = matrices[i];
+		LifeState phase = glider.transform(0, 0, m[0], m[1], m[2], m[3]);
+		phase.setGliderRemoval(GLIDERS_OFF);
+		for (int p=0; p<4; ++p)
+		{
+			locators.push_back(phase.toLifeLocator().withBoundary());
+			phase.run(1);
+		}
+	}
+	return locators;
+}
+
+// All four phases of all four gliders, at every column within `width`
+// of the edge.
+void LifeState::removeGlidersInBand(int width)
+{
+	static const std::vector<LifeLocator> phase_locators = MakePhaseLocators();
+	// ON cells sit up to 3 rows either side of the column they're found at.
+	uint64_t band = 0;
+	for (int k=-width-3; k<=width+3; ++k)
+	{
+		band |= 1ULL << ((k + 64) & 63);
+	}
+	if ((this->rows & band) == 0)
+	{
+		return;
+	}
+	bool removed = false;
+	for (size_t i=0; i<phase_locators.size(); ++i)
+	{
+		for (int x=-32-width; x<=-32+width; ++x)
+		{
+			removed = this->removeGlidersAt(phase_locators[i], (int)i / 4, x) || removed;
+		}
+	}
+	if (removed)
+	{
+		this->refitBounds();
+	}
+}
+
+int SpaceshipCatalog::add(const char* rle, int period)
+{
+	LifeState first(rle);
+	first.setGliderRemoval(GLIDERS_OFF);
+	int x0, y0, w0, h0, x1, y1, w1, h1;
+	if (period < 1 || !first.getBoundingBox(x0, y0, w0, h0))
+	{
+		return -1;
+	}
+	LifeState last = first.after(period);
+	if (!last.getBoundingBox(x1, y1, w1, h1) || !(first.transform(x1 - x0, y1 - y0) == last))
+	{
+		return -1;
+	}
+	Ship ship;
+	ship.dx = (x1 > x0) - (x1 < x0);
+	ship.dy = (y1 > y0) - (y1 < y0);
+	if (ship.dx == 0 && ship.dy == 0)
+	{
+		return -1;
+	}
+	int index = (int)this->ships.size();
+	this->ships.push_back(ship);
+	std::vector<LifeLocator> added;
+	for (int o=0; o<8; ++o)
+	{
+		const int* m = OrientationMatrices[o];
+		LifeState phase = first.transform((Orientation)o);
+		for (int p=0; p<period; ++p)
+		{
+			this->addShape(phase, index, m[0] * ship.dx + m[1] * ship.dy, m[2] * ship.dx + m[3] * ship.dy, added);
+			phase.run(1);
+		}
+	}
+	this->locators.add(added);
+	return index;
+}
+
+void SpaceshipCatalog::addStandardShips()
+{
+	this->add("bo$2bo$3o!", 4);
+	this->add("bo2bo$o4b$o3bo$4o!", 4);
+	this->add("3bo2b$bo3bo$o5b$o4bo$5o!", 4);
+	this->add("3b2o2b$bo4bo$o6b$o5bo$6o!", 4);
+}
+
+// The shape's cells relative to the top-left corner of its bounding box,
+// and the ring around them. Symmetric ships give the same shape from
+// several orientations; only the first is kept.
+bool SpaceshipCatalog::addShape(const LifeState& s, int ship, int dx, int dy, std::vector<LifeLocator>& added)
+{
+	int x, y, w, h;
+	if (!s.getBoundingBox(x, y, w, h))
+	{
+		return false;
+	}
+	LifeLocator l = s.transform(-x, -y).toLifeLocator().withBoundary();
+	int known = this->locators.size();
+	for (int k=0; k<known + (int)added.size(); ++k)
+	{
+		const CellList& on = (k < known) ? this->locators[k].on : added[k - known].on;
+		if (on.size() != l.on.size())
+		{
+			continue;
+		}
+		bool same = true;
+		for (size_t n=0; n<on.size() && same; ++n)
+		{
+			same = on[n].x == l.on[n].x && on[n].y == l.on[n].y;
+		}
+		if (same)
+		{
+			return false;
+		}
+	}
+	Shape shape = {ship, dx, dy};
+	this->shapes.push_back(shape);
+	added.push_back(l);
+	this->band = std::max(this->band, std::max(w, h) + 2);
+	return true;
+}
+
+// Cell tests are keyed by offset mod 64 and polarity, so offsets that
+// test the same cell on the torus share a key.
+static inline int LiteralKey(const Cell& c, bool on)
+{
+	return (((c.x & 63) << 6) | (c.y & 63)) << 1 | (on ? 1 : 0);
+}
+
+struct LocatorTrie
+{
+	int key;
+	std::map<int, int> children; // rank -> trie index
+	std::vector<int> locators;
+};
+
+struct LocatorNode
+{
+	int key;
+	int depth;
+	int skip;
+	int firstLocator;
+	int locatorCount;
+};
+
+// Depth first, so a node's subtree is the run of nodes that follows it.
+static void FlattenTrie(const std::vector<LocatorTrie>& trie, int t, int depth,
+                        std::vector<LocatorNode>& out, std::vector<int>& outLocators)
+{
+	for (std::map<int, int>::const_iterator it = trie[t].children.begin(); it != trie[t].children.end(); ++it)
+	{
+		const LocatorTrie& child = trie[it->second];
+		LocatorNode node;
+		node.key = child.key;
+		node.depth = depth;
+		node.firstLocator = (int)outLocators.size();
+		node.locatorCount = (int)child.locators.size();
+		outLocators.insert(outLocators.end(), child.locators.begin(), child.locators.end());
+		size_t index = out.size();
+		out.push_back(node);
+		FlattenTrie(trie, it->second, depth + 1, out, outLocators);
+		out[index].skip = (int)out.size();
+	}
+}
+
+int LocatorSet::add(const LifeLocator& l)
+{
+	this->locators.push_back(l);
+	this->compile();
+	return (int)this->locators.size() - 1;
+}
+
+int LocatorSet::add(const std::vector<LifeLocator>& ls)
+{
+	int first = (int)this->locators.size();
+	this->locators.insert(this->locators.end(), ls.begin(), ls.end());
+	this->compile();
+	return first;
+}
+
+std::vector<LifeState> LocatorSet::locate(const LifeState& s) const
+{
+	std::vector<LifeState> matches;
+	this->locate(s, matches);
+	return matches;
+}
+
+void LocatorSet::locate(const LifeState& s, std::vector<LifeState>& matches) const
+{
+	matches.assign(this->locators.size(), LifeState());
+	// A locator with no cells matches everywhere, and has no node to say so.
+	for (size_t k=0; k<this->locators.size(); ++k)
+	{
+		if (this->locators[k].on.empty() && this->locators[k].off.empty())
+		{
+			matches[k] = ~LifeState();
+		}
+	}
+	// A row can only match where one of the root tests can.
+	uint64_t candidates = 0;
+	for (size_t n=0; n<this->nodes.size(); n=this->nodes[n].skip)
+	{
+		candidates |= this->nodes[n].on ? CirculateRight(s.rows, this->nodes[n].dx & 63) : ~0ULL;
+	}
+	std::vector<uint64_t> acc(this->maxDepth + 1);
+	std::vector<std::pair<int, uint64_t> > hits;
+	for (; candidates != 0; candidates &= candidates - 1)
+	{
+		int i = LowestBit(candidates);
+		hits.clear();
+		this->matchColumn(s.state, i - 32, ~0ULL, &acc[0], hits);
+		for (size_t h=0; h<hits.size(); ++h)
+		{
+			LifeState& m = matches[hits[h].first];
+			m.state[i] = hits[h].second;
+			m.rows |= 1ULL << i;
+			m.cols |= hits[h].second;
+		}
+	}
+}
+
+// ON tests come first, since few cells are live, then the tests most
+// locators share, so the top of the tree is shared as widely as possible.
+void LocatorSet::compile()
+{
+	std::map<int, int> counts;
+	for (size_t s=0; s<this->locators.size(); ++s)
+	{
+		for (size_t n=0; n<this->locators[s].on.size(); ++n)
+		{
+			counts[LiteralKey(this->locators[s].on[n], true)]++;
+		}
+		for (size_t n=0; n<this->locators[s].off.size(); ++n)
+		{
+			counts[LiteralKey(this->locators[s].off[n], false)]++;
+		}
+	}
+	std::vector<std::pair<std::pair<int, int>, int> > order;
+	for (std::map<int, int>::const_iterator it = counts.begin(); it != counts.end(); ++it)
+	{
+		order.push_back(std::make_pair(std::make_pair(-(it->first & 1), -it->second), it->first));
+	}
+	std::sort(order.begin(), order.end());
+	std::map<int, int> rank;
+	for (size_t r=0; r<order.size(); ++r)
+	{
+		rank[order[r].second] = (int)r;
+	}
+
+	std::vector<LocatorTrie> trie(1);
+	trie[0].key = 0;
+	for (size_t s=0; s<this->locators.size(); ++s)
+	{
+		std::vector<std::pair<int, int> > literals;
+		for (size_t n=0; n<this->locators[s].on.size(); ++n)
+		{
+			int key = LiteralKey(this->locators[s].on[n], true);
+			literals.push_back(std::make_pair(rank[key], key));
+		}
+		for (size_t n=0; n<this->locators[s].off.size(); ++n)
+		{
+			int key = LiteralKey(this->locators[s].off[n], false);
+			literals.push_back(std::make_pair(rank[key], key));
+		}
+		std::sort(literals.begin(), literals.end());
+		int t = 0;
+		for (size_t n=0; n<literals.size(); ++n)
+		{
+			std::map<int, int>::iterator it = trie[t].children.find(literals[n].first);
+			if (it == trie[t].children.end())
+			{
+				LocatorTrie child;
+				child.key = literals[n].second;
+				trie.push_back(child);
+				it = trie[t].children.insert(std::make_pair(literals[n].first, (int)trie.size() - 1)).first;
+			}
+			t = it->second;
+		}
+		trie[t].locators.push_back((int)s);
+	}
+
+	std::vector<LocatorNode> flat;
+	this->nodeLocators.clear();
+	FlattenTrie(trie, 0, 0, flat, this->nodeLocators);
+	this->nodes.clear();
+	this->maxDepth = 0;
+	for (size_t n=0; n<flat.size(); ++n)
+	{
+		Node node;
+		node.dx = (flat[n].key >> 7) & 63;
+		node.dy = (flat[n].key >> 1) & 63;
+		node.on = (flat[n].key & 1) != 0;
+		node.depth = flat[n].depth;
+		node.skip = flat[n].skip;
+		node.firstLocator = flat[n].firstLocator;
+		node.locatorCount = flat[n].locatorCount;
+		this->maxDepth = std::max(this->maxDepth, node.depth + 1);
+		this->nodes.push_back(node);
+	}
+}
+
+// acc[d] is the AND of the tests on the path down to depth d.
+void LocatorSet::matchColumn(const uint64_t* state, int x, uint64_t filter, uint64_t* acc,
+                             std::vector<std::pair<int, uint64_t> >& hits) const
+{
+	acc[0] = filter;
+	size_t n = 0;
+	while (n < this->nodes.size())
+	{
+		const Node& node = this->nodes[n];
+		uint64_t word = CirculateRight(state[(x + 32 + node.dx) & 63], node.dy & 63);
+		uint64_t value = acc[node.depth] & (node.on ? word : ~word);
+		if (value == 0)
+		{
+			n = node.skip;
+			continue;
+		}
+		acc[node.depth + 1] = value;
+		for (int k=0; k<node.locatorCount; ++k)
+		{
+			hits.push_back(std::make_pair(this->nodeLocators[node.firstLocator + k], value));
+		}
+		n++;
+	}
+}
+
+// Rows (or columns) whose cells a check could touch: anchors within the
+// band of the edge, plus the extent of the largest ship past them.
+static uint64_t SpaceshipEdgeMask(int band)
+{
+	uint64_t mask = 0;
+	for (int k=-band-1; k<=2*band; ++k)
+	{
+		mask |= 1ULL << ((k + 64) & 63);
+	}
+	return mask;
+}
+
+// Ships with their corner in a column near the x edge are looked for in
+// every row; elsewhere only corners near the y edge are.
+int LifeState::removeSpaceships(const SpaceshipCatalog& catalog)
+{
+	int band = catalog.band;
+	if (catalog.locators.size() == 0)
+	{
+		return 0;
+	}
+	uint64_t edge = SpaceshipEdgeMask(band);
+	if ((this->rows & edge) == 0 && (this->cols & edge) == 0)
+	{
+		return 0;
+	}
+	uint64_t yBand = 0;
+	for (int k=-band; k<=band; ++k)
+	{
+		yBand |= 1ULL << ((k + 64) & 63);
+	}
+
+	// Nothing is allocated unless the tree is deep or something matches.
+	uint64_t accBuffer[256];
+	std::vector<uint64_t> accHeap;
+	uint64_t* acc = accBuffer;
+	if (catalog.locators.maxDepth + 1 > 256)
+	{
+		accHeap.resize(catalog.locators.maxDepth + 1);
+		acc = &accHeap[0];
+	}
+	std::vector<std::pair<int, uint64_t> > hits;
+	int count = 0;
+	for (int i=0; i<64; ++i)
+	{
+		int x = i - 32;
+		int d = std::min(i, 64 - i);
+		uint64_t filter = (d <= band) ? ~0ULL : yBand;
+		if ((this->cols & filter) == 0)
+		{
+			continue;
+		}
+		hits.clear();
+		catalog.locators.matchColumn(this->state, x, filter, acc, hits);
+		for (size_t h=0; h<hits.size(); ++h)
+		{
+			const SpaceshipCatalog::Shape& shape = catalog.shapes[hits[h].first];
+			const CellList& on = catalog.locators[hits[h].first].on;
+			uint64_t anchors = hits[h].second;
+			for (size_t n=0; n<on.size(); ++n)
+			{
+				const Cell& c = on[n];
+				this->state[(x + 32 + c.x) & 63] &= ~CirculateLeft(anchors, c.y & 63);
+			}
+			count += __builtin_popcountll(anchors);
+			for (; anchors != 0; anchors &= anchors - 1)
+			{
+				SpaceshipData data;
+				data.ship = shape.ship;
+				data.x = x;
+				data.y = LowestBit(anchors) - 32;
+				data.gen = this->gen;
+				data.dx = shape.dx;
+				data.dy = shape.dy;
+				this->logSpaceship(data);
+			}
+		}
+	}
+	if (count > 0)
+	{
+		this->refitBounds();
+	}
+	return count;
+}
+
+// The rows x where ON cells of `target` can all land on live rows: with
+// a cell at (cx, cy), row x + cx has to be live.
+static uint64_t CandidateRows(uint64_t rows, const CellList& target)
+{
+	uint64_t candidates = ~0ULL;
+	for(CellList::const_iterator it = target.begin(); it != target.end() && candidates != 0; ++it)
+	{
+		candidates &= CirculateRight(rows, ((it->x % 64) + 64) % 64);
+	}
+	return candidates;
+}
+
+LifeState LifeState::locate(const CellList& target, bool on) const
+{
+	LifeState locations;
+	uint64_t candidates = on ? CandidateRows(this->rows, target) : ~0ULL;
+	for (; candidates != 0; candidates &= candidates - 1)
+	{
+		int i = LowestBit(candidates);
+		uint64_t x_locations = this->locateAtX(target, i-32, on);
+		if (x_locations != 0)
+		{
+			locations.state[i] = x_locations;
+			locations.rows |= 1ULL << i;
+			locations.cols |= x_locations;
+		}
+	}
+	return locations;
+}
+
+// Rows are matched LifeLocator::LANES at a time, and a group of rows is
+// dropped as soon as none of them has a match left.
+LifeState LifeState::locate(const LifeLocator& l) const
+{
+	const int LANES = LifeLocator::LANES;
+	l.refresh();
+	LifeState locations;
+	uint64_t candidates = CandidateRows(this->rows, l.on);
+	if (candidates == 0)
+	{
+		return locations;
+	}
+	uint64_t columns[128];
+	for (int k=0; k<128; ++k)
+	{
+		columns[k] = this->state[k & 63];
+	}
+	for (int base=0; base<64; base+=LANES)
+	{
+		uint64_t lanes = (candidates >> base) & ((1ULL << LANES) - 1);
+		if (lanes == 0)
+		{
+			continue;
+		}
+		uint64_t acc[LANES];
+		for (int j=0; j<LANES; ++j)
+		{
+			acc[j] = ((lanes >> j) & 1) ? ~0ULL : 0;
+		}
+		if (!l.matchLanes(columns, base, acc))
+		{
+			continue;
+		}
+		for (int j=0; j<LANES; ++j)
+		{
+			if (acc[j] != 0)
+			{
+				locations.state[base + j] = acc[j];
+				locations.rows |= 1ULL << (base + j);
+				locations.cols |= acc[j];
+			}
+		}
+	}
+	return locations;
+}
+
+LifeState LifeState::locate(const LifeLocator& l, int maxMismatches) const
+{
+	assert(maxMismatches >= 0);
+	if (maxMismatches == 0)
+	{
+		return this->locate(l);
+	}
+	l.refresh();
+	LifeState locations;
+	for (int i=0; i<64; ++i)
+	{
+		uint64_t x_locations = this->locateAtX(l, i-32, maxMismatches);
+		if (x_locations != 0)
+		{
+			locations.state[i] = x_locations;
+			locations.rows |= 1ULL << i;
+			locations.cols |= x_locations;
+		}
+	}
+	return locations;
+}
+
+// All matches in a row are removed together.
+void LifeState::remove(const LifeLocator& l)
+{
+	LifeState locations = this->locate(l);
+	for (uint64_t rows = locations.rows; rows != 0; rows &= rows - 1)
+	{
+		int i = LowestBit(rows);
+		this->removeAtX(l.on, i - 32, locations.state[i]);
+	}
+	this->refitBounds();
+}
+
+// LifeTargets: targets with fixed positions.
+LifeTarget::LifeTarget()
+{
+	this->on.clear();
+	this->off.clear();
+}
+
+// Initialize a `LifeTarget` with only on cells.
+LifeTarget::LifeTarget(const LifeState& s)
+{
+	this->on = s;
+	this->off.clear();
+}
+
+// Initialize a `LifeTarget` with both on and off targets.
+LifeTarget::LifeTarget(const LifeState& on, const LifeState& off)
+{
+	this->on = on;
+	this->off = off;
+}
+
+// Return a new LifeTarget with the same ON target
+// and the OFF target surrounding size `size` boundary.
+LifeTarget LifeTarget::withBoundary(int size) const
+{
+	assert(size > 0);
+	LifeState on = this->on;
+	LifeState off = this->on.dilate(-size, -size, size*2+1, size*2+1) - (this->on);
+	return LifeTarget(on, off);
+}
+
+// See if target matches `LifeState s`.
+inline bool LifeTarget::in(const LifeState& s) const
+{
+	return s.contains(this->on) && s.isDisjoint(this->off);
+}
+
+// LifeGrid: a bounded plane made of 64x64 tiles.
+
+LifeGrid::LifeGrid(int width, int height)
+{
+	assert(width > 0 && height > 0);
+	this->width = width;
+	this->height = height;
+	this->tilesX = (width + 64 - 1) / 64;
+	this->tilesY = (height + 64 - 1) / 64;
+	this->tiles.assign(64 * this->tilesX * this->tilesY, 0);
+	this->changed.assign(this->tilesX * this->tilesY, 0);
+	this->scheduled.assign(this->tilesX * this->tilesY, 0);
+	this->gen = 0;
+}
+
+void LifeGrid::clear()
+{
+	std::fill(this->tiles.begin(), this->tiles.end(), 0);
+	std::fill(this->changed.begin(), this->changed.end(), 0);
+	this->changedList.clear();
+	this->gen = 0;
+}
+
+void LifeGrid::markChanged(int tx, int ty)
+{
+	int idx = ty * this->tilesX + tx;
+	if (!this->changed[idx])
+	{
+		this->changed[idx] = 1;
+		this->changedList.push_back(idx);
+	}
+}
+
+// Bits of tile row `tileY` that lie inside the plane.
+uint64_t LifeGrid::rowMask(int tileY) const
+{
+	int rows = this->height - 64 * tileY;
+	return (rows >= 64) ? ~0ULL : ((1ULL << rows) - 1);
+}
+
+void LifeGrid::setCell(int x, int y, int val)
+{
+	if (x < 0 || y < 0 || x >= this->width || y >= this->height)
+	{
+		return;
+	}
+	if (val)
+	{
+		Set(this->tile(x / 64, y / 64), x % 64, y % 64);
+	}
+	else
+	{
+		Erase(this->tile(x / 64, y / 64), x % 64, y % 64);
+	}
+	this->markChanged(x / 64, y / 64);
+}
+
+int LifeGrid::getCell(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= this->width || y >= this->height)
+	{
+		return 0;
+	}
+	return Get(this->tile(x / 64, y / 64), x % 64, y % 64);
+}
+
+int LifeGrid::getPop() const
+{
+	int pop = 0;
+	for (size_t i = 0; i < this->tiles.size(); i++)
+	{
+		pop += __builtin_popcountll(this->tiles[i]);
+	}
+	return pop;
+}
+
+// Column `x` of tile row `tileY`, or 0 outside the plane.
+uint64_t LifeGrid::column(int x, int tileY) const
+{
+	if (x < 0 || x >= 64 * this->tilesX || tileY < 0 || tileY >= this->tilesY)
+	{
+		return 0;
+	}
+	return this->tile(x / 64, tileY)[x % 64];
+}
+
+// The 64 cells (x, y) ... (x, y + 63), where y may straddle two tiles.
+uint64_t LifeGrid::getColumn(int x, int y) const
+{
+	int tileY = (y >= 0) ? (y / 64) : -((-y + 64 - 1) / 64);
+	int offset = y - 64 * tileY;
+	uint64_t bits = this->column(x, tileY) >> offset;
+	if (offset > 0)
+	{
+		bits |= this->column(x, tileY + 1) << (64 - offset);
+	}
+	return bits;
+}
+
+void LifeGrid::orColumn(int x, int y, uint64_t bits)
+{
+	if (x < 0 || x >= this->width || bits == 0)
+	{
+		return;
+	}
+	int tileY = (y >= 0) ? (y / 64) : -((-y + 64 - 1) / 64);
+	int offset = y - 64 * tileY;
+	uint64_t parts[2] = { bits << offset, (offset > 0) ? (bits >> (64 - offset)) : 0 };
+	for (int k = 0; k < 2; k++)
+	{
+		int ty = tileY + k;
+		if (ty < 0 || ty >= this->tilesY)
+		{
+			continue;
+		}
+		uint64_t part = parts[k] & this->rowMask(ty);
+		if (part != 0)
+		{
+			this->tile(x / 64, ty)[x % 64] |= part;
+			this->markChanged(x / 64, ty);
+		}
+	}
+}
+
+void LifeGrid::join(const LifeState& s, int x, int y)
+{
+	for (int i = 0; i < 64; i++)
+	{
+		this->orColumn(x + i - 32, y - 32, s.state[i]);
+	}
+}
+
+LifeState LifeGrid::toLifeState(int x, int y) const
+{
+	LifeState result;
+	for (int i = 0; i < 64; i++)
+	{
+		result.state[i] = this->getColumn(x + i - 32, y - 32);
+	}
+	result.gen = this->gen;
+	result.recalculateBounds();
+	return result;
+}
+
+// Same bit-sliced pipeline as LifeState::iterate(), but the neighbours
+// across the tile edges come from the adjacent tiles instead of wrapping.
+void LifeGrid::stepTile(int tx, int ty, uint64_t* result) const
+{
+	uint64_t col[66], l[66], r[66], bit0[66], bit1[66];
+	for (int k = 0; k < 66; k++)
+	{
+		int x = 64 * tx + k - 1;
+		uint64_t m = this->column(x, ty);
+		col[k] = m;
+		l[k] = (m << 1) | (this->column(x, ty - 1) >> 63);
+		r[k] = (m >> 1) | (this->column(x, ty + 1) << 63);
+		bit0[k] = l[k] ^ r[k] ^ m;
+		bit1[k] = ((l[k] | r[k]) & m) | (l[k] & r[k]);
+	}
+
+	uint64_t mask = this->rowMask(ty);
+	int columns = this->width - 64 * tx;
+	for (int i = 0; i < 64; i++)
+	{
+		if (i >= columns)
+		{
+			result[i] = 0;
+			continue;
+		}
+		result[i] = mask & evolve(col[i + 1], l[i + 1], r[i + 1], bit0[i], bit1[i], bit0[i + 2], bit1[i + 2]);
+	}
+}
+
+// A tile can only change if something in its 3x3 tile neighbourhood
+// changed in the previous generation.
+void LifeGrid::step()
+{
+	std::vector<int> active;
+	for (size_t n = 0; n < this->changedList.size(); n++)
+	{
+		int idx = this->changedList[n];
+		int tx = idx % this->tilesX;
+		int ty = idx / this->tilesX;
+		this->changed[idx] = 0;
+		for (int dy = -1; dy <= 1; dy++)
+		{
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				int x = tx + dx;
+				int y = ty + dy;
+				if (x < 0 || y < 0 || x >= this->tilesX || y >= this->tilesY)
+				{
+					continue;
+				}
+				int neighbour = y * this->tilesX + x;
+				if (!this->scheduled[neighbour])
+				{
+					this->scheduled[neighbour] = 1;
+					active.push_back(neighbour);
+				}
+			}
+		}
+	}
+	this->changedList.clear();
+
+	std::vector<uint64_t> next(64 * active.size());
+	for (size_t n = 0; n < active.size(); n++)
+	{
+		this->stepTile(active[n] % this->tilesX, active[n] / this->tilesX, &next[64 * n]);
+	}
+
+	for (size_t n = 0; n < active.size(); n++)
+	{
+		int idx = active[n];
+		uint64_t* words = &this->tiles[64 * idx];
+		this->scheduled[idx] = 0;
+		bool differs = false;
+		for (int i = 0; i < 64; i++)
+		{
+			differs = differs || (words[i] != next[64 * n + i]);
+			words[i] = next[64 * n + i];
+		}
+		if (differs)
+		{
+			this->markChanged(idx % this->tilesX, idx / this->tilesX);
+		}
+	}
+	this->gen++;
+}
+
+void LifeGrid::run(int gens)
+{
+	assert(gens > 0);
+	for (int i = 0; i < gens; i++)
+	{
+		this->step();
+	}
+}
+
+// HashLife: a memoized quadtree over the unbounded plane.
+
+HashLife::HashLife(size_t maxNodes)
+{
+	this->maxNodes = maxNodes;
+	this->reset();
+}
+
+HashLife::HashLife(const LifeState& s, size_t maxNodes)
+{
+	this->maxNodes = maxNodes;
+	this->setState(s);
+}
+
+void HashLife::reset()
+{
+	// Nodes 0 and 1 are the dead and the live cell.
+	Node dead = {-1, -1, -1, -1, 0, 0, -1, 0, 0};
+	Node alive = {-1, -1, -1, -1, 0, 1, -1, 0, 0};
+	this->nodes.clear();
+	this->nodes.push_back(dead);
+	this->nodes.push_back(alive);
+	this->emptyNodes.assign(1, 0);
+	this->table.assign(1 << 16, -1);
+	this->clock = 0;
+	this->gen = 0;
+	this->root = this->empty(6);
+}
+
+static inline size_t HashNode(int nw, int ne, int sw, int se)
+{
+	uint64_t h = (uint64_t)nw * 0x9E3779B97F4A7C15ULL;
+	h = (h ^ (uint64_t)ne) * 0xC2B2AE3D27D4EB4FULL;
+	h = (h ^ (uint64_t)sw) * 0x165667B19E3779F9ULL;
+	h = (h ^ (uint64_t)se) * 0x9E3779B97F4A7C15ULL;
+	return (size_t)(h ^ (h >> 29));
+}
+
+void HashLife::rehash(size_t size)
+{
+	this->table.assign(size, -1);
+	size_t mask = size - 1;
+	for (size_t idx = 2; idx < this->nodes.size(); idx++)
+	{
+		const Node& n = this->nodes[idx];
+		size_t i = HashNode(n.nw, n.ne, n.sw, n.se) & mask;
+		while (this->table[i] != -1)
+		{
+			i = (i + 1) & mask;
+		}
+		this->table[i] = (int)idx;
+	}
+}
+
+// The unique node with these four children.
+int HashLife::join(int nw, int ne, int sw, int se)
+{
+	size_t mask = this->table.size() - 1;
+	size_t i = HashNode(nw, ne, sw, se) & mask;
+	while (this->table[i] != -1)
+	{
+		Node& n = this->nodes[this->table[i]];
+		if (n.nw == nw && n.ne == ne && n.sw == sw && n.se == se)
+		{
+			n.lastUsed = this->clock;
+			return this->table[i];
+		}
+		i = (i + 1) & mask;
+	}
+	long long pop = this->nodes[nw].pop + this->nodes[ne].pop + this->nodes[sw].pop + this->nodes[se].pop;
+	Node n = {nw, ne, sw, se, this->nodes[nw].level + 1, pop, -1, 0, this->clock};
+	int idx = (int)this->nodes.size();
+	this->nodes.push_back(n);
+	this->table[i] = idx;
+	if (2 * this->nodes.size() > this->table.size())
+	{
+		this->rehash(2 * this->table.size());
+	}
+	return idx;
+}
+
+int HashLife::empty(int level)
+{
+	while ((int)this->emptyNodes.size() <= level)
+	{
+		int e = this->emptyNodes.back();
+		this->emptyNodes.push_back(this->join(e, e, e, e));
+	}
+	return this->emptyNodes[level];
+}
+
+// The node for the 2^level square with top-left cell (x, y) of `s`.
+int HashLife::build(const LifeState& s, int level, int x, int y)
+{
+	if (level == 0)
+	{
+		return s.getCell(x, y);
+	}
+	int half = 1 << (level - 1);
+	int nw = this->build(s, level - 1, x, y);
+	int ne = this->build(s, level - 1, x + half, y);
+	int sw = this->build(s, level - 1, x, y + half);
+	int se = this->build(s, level - 1, x + half, y + half);
+	return this->join(nw, ne, sw, se);
+}
+
+// The LifeState is taken as a 64x64 patch of the plane around (0, 0).
+void HashLife::setState(const LifeState& s)
+{
+	this->reset();
+	this->root = this->build(s, 6, -32, -32);
+	this->gen = s.gen;
+}
+
+long long HashLife::getPop() const
+{
+	return this->nodes[this->root].pop;
+}
+
+int HashLife::centre(int n)
+{
+	Node c = this->nodes[n];
+	return this->join(this->nodes[c.nw].se, this->nodes[c.ne].sw, this->nodes[c.sw].ne, this->nodes[c.se].nw);
+}
+
+// A node one level up, with `n` in its centre.
+int HashLife::expand(int n)
+{
+	Node c = this->nodes[n];
+	int e = this->empty(c.level - 1);
+	int nw = this->join(e, e, e, c.nw);
+	int ne = this->join(e, e, c.ne, e);
+	int sw = this->join(e, c.sw, e, e);
+	int se = this->join(c.se, e, e, e);
+	return this->join(nw, ne, sw, se);
+}
+
+// True if all live cells are in the central 2^(level-2) square.
+bool HashLife::isCentred(int n) const
+{
+	const Node& c = this->nodes[n];
+	if (c.level < 3)
+	{
+		return false;
+	}
+	const Node& nw = this->nodes[c.nw];
+	const Node& ne = this->nodes[c.ne];
+	const Node& sw = this->nodes[c.sw];
+	const Node& se = this->nodes[c.se];
+	return nw.pop == this->nodes[this->nodes[nw.se].se].pop
+		&& ne.pop == this->nodes[this->nodes[ne.sw].sw].pop
+		&& sw.pop == this->nodes[this->nodes[sw.ne].ne].pop
+		&& se.pop == this->nodes[this->nodes[se.nw].nw].pop;
+}
+
+int HashLife::cellAt(int n, int x, int y) const
+{
+	while (this->nodes[n].level > 0)
+	{
+		const Node& c = this->nodes[n];
+		int half = 1 << (c.level - 1);
+		bool east = (x >= half);
+		bool south = (y >= half);
+		n = south ? (east ? c.se : c.sw) : (east ? c.ne : c.nw);
+		x -= east ? half : 0;
+		y -= south ? half : 0;
+	}
+	return n;
+}
+
+// The centre of `n` (one level down) after 2^k generations, k <= level-2.
+// At k == level-2 both halves of the step advance time (full speed);
+// for smaller k the first half only re-centres.
+int HashLife::successor(int n, int k)
+{
+	Node c = this->nodes[n];
+	if (c.pop == 0)
+	{
+		return this->empty(c.level - 1);
+	}
+	if (c.result != -1 && c.resultStep == k)
+	{
+		this->nodes[n].lastUsed = this->clock;
+		return c.result;
+	}
+	assert(k <= c.level - 2);
+
+	int result;
+	if (c.level == 2)
+	{
+		int cells[4];
+		for (int i = 0; i < 4; i++)
+		{
+			int x = 1 + (i & 1);
+			int y = 1 + (i >> 1);
+			int count = 0;
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dx = -1; dx <= 1; dx++)
+				{
+					count += (dx || dy) ? this->cellAt(n, x + dx, y + dy) : 0;
+				}
+			}
+			cells[i] = (count == 3 || (count == 2 && this->cellAt(n, x, y))) ? 1 : 0;
+		}
+		result = this->join(cells[0], cells[1], cells[2], cells[3]);
+	}
+	else
+	{
+		Node nw = this->nodes[c.nw];
+		Node ne = this->nodes[c.ne];
+		Node sw = this->nodes[c.sw];
+		Node se = this->nodes[c.se];
+		int parts[9] = {
+			c.nw,
+			this->join(nw.ne, ne.nw, nw.se, ne.sw),
+			c.ne,
+			this->join(nw.sw, nw.se, sw.nw, sw.ne),
+			this->join(nw.se, ne.sw, sw.ne, se.nw),
+			this->join(ne.sw, ne.se, se.nw, se.ne),
+			c.sw,
+			this->join(sw.ne, se.nw, sw.se, se.sw),
+			c.se
+		};
+		bool full = (k == c.level - 2);
+		for (int i = 0; i < 9; i++)
+		{
+			parts[i] = full ? this->successor(parts[i], k - 1) : this->centre(parts[i]);
+		}
+		int step = full ? (k - 1) : k;
+		int rnw = this->successor(this->join(parts[0], parts[1], parts[3], parts[4]), step);
+		int rne = this->successor(this->join(parts[1], parts[2], parts[4], parts[5]), step);
+		int rsw = this->successor(this->join(parts[3], parts[4], parts[6], parts[7]), step);
+		int rse = this->successor(this->join(parts[4], parts[5], parts[7], parts[8]), step);
+		result = this->join(rnw, rne, rsw, rse);
+	}
+	Node& memo = this->nodes[n];
+	memo.result = result;
+	memo.resultStep = k;
+	memo.lastUsed = this->clock;
+	return result;
+}
+
+// Keep the current pattern, then the most recently used nodes (with their
+// subtrees) up to half of maxNodes, and drop everything else.
+void HashLife::collect()
+{
+	size_t count = this->nodes.size();
+	std::vector<std::pair<unsigned, int> > byAge;
+	byAge.reserve(count);
+	for (size_t i = 2; i < count; i++)
+	{
+		byAge.push_back(std::make_pair(this->nodes[i].lastUsed, (int)i));
+	}
+	std::sort(byAge.begin(), byAge.end(), std::greater<std::pair<unsigned, int> >());
+
+	std::vector<char> keep(count, 0);
+	keep[0] = keep[1] = 1;
+	size_t kept = 2;
+	std::vector<int> stack;
+	for (size_t c = 0; c <= byAge.size(); c++)
+	{
+		int candidate = (c == 0) ? this->root : byAge[c - 1].second;
+		if (c > 0 && kept >= this->maxNodes / 2)
+		{
+			break;
+		}
+		stack.push_back(candidate);
+		while (!stack.empty())
+		{
+			int n = stack.back();
+			stack.pop_back();
+			if (keep[n])
+			{
+				continue;
+			}
+			keep[n] = 1;
+			kept++;
+			stack.push_back(this->nodes[n].nw);
+			stack.push_back(this->nodes[n].ne);
+			stack.push_back(this->nodes[n].sw);
+			stack.push_back(this->nodes[n].se);
+		}
+	}
+
+	// Children always precede their parents, so one pass remaps them.
+	std::vector<int> remap(count, -1);
+	std::vector<Node> compact;
+	compact.reserve(kept);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!keep[i])
+		{
+			continue;
+		}
+		Node n = this->nodes[i];
+		if (i >= 2)
+		{
+			n.nw = remap[n.nw];
+			n.ne = remap[n.ne];
+			n.sw = remap[n.sw];
+			n.se = remap[n.se];
+		}
+		remap[i] = (int)compact.size();
+		compact.push_back(n);
+	}
+	for (size_t i = 0; i < compact.size(); i++)
+	{
+		int result = compact[i].result;
+		compact[i].result = (result != -1 && keep[result]) ? remap[result] : -1;
+	}
+	this->nodes.swap(compact);
+	this->root = remap[this->root];
+	this->emptyNodes.assign(1, 0);
+	size_t size = 1 << 16;
+	while (size < 2 * this->nodes.size())
+	{
+		size *= 2;
+	}
+	this->rehash(size);
+}
+
+void HashLife::step(int k)
+{
+	// The root grows to level k + 3 and toLifeState() places its corners
+	// with long long coordinates.
+	assert(k >= 0 && k < 60);
+	if (this->nodes.size() > this->maxNodes)
+	{
+		this->collect();
+	}
+	this->clock++;
+	while (this->nodes[this->root].level < k + 2 || !this->isCentred(this->root))
+	{
+		this->root = this->expand(this->root);
+	}
+	// One more level, so the pattern can grow at the speed of light
+	// for the whole step without reaching the edge of the result.
+	this->root = this->expand(this->root);
+	this->root = this->successor(this->root, k);
+	this->gen += (1LL << k);
+}
+
+void HashLife::run(int gens)
+{
+	assert(gens > 0);
+	for (int k = 0; gens > 0; k++, gens >>= 1)
+	{
+		if (gens & 1)
+		{
+			this->step(k);
+		}
+	}
+}
+
+void HashLife::extract(int n, long long x, long long y, int wx, int wy, LifeState& result) const
+{
+	const Node& c = this->nodes[n];
+	long long size = 1LL << c.level;
+	if (c.pop == 0 || x + size <= wx - 32 || x >= wx + 32 || y + size <= wy - 32 || y >= wy + 32)
+	{
+		return;
+	}
+	if (c.level == 0)
+	{
+		result.setCell((int)(x - wx), (int)(y - wy), 1);
+		return;
+	}
+	long long half = size / 2;
+	this->extract(c.nw, x, y, wx, wy, result);
+	this->extract(c.ne, x + half, y, wx, wy, result);
+	this->extract(c.sw, x, y + half, wx, wy, result);
+	this->extract(c.se, x + half, y + half, wx, wy, result);
+}
+
+LifeState HashLife::toLifeState(int x, int y) const
+{
+	LifeState result;
+	long long corner = -(1LL << (this->nodes[this->root].level - 1));
+	this->extract(this->root, corner, corner, x, y, result);
+	result.gen = (int)this->gen; // Truncated past 2^31 generations
+	result.recalculateBounds();
+	return result;
+}
+
+std::string HashLife::toRLE() const
+{
+	return this->toLifeState().toRLE();
+}
+
+// LifeBatch: lockstep evolution of many states.
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__linux__) && defined(__x86_64__)
+	// Let the dynamic loader pick the widest vectorization of the lane loops.
+	#define LIFE_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+	#define LIFE_TARGET_CLONES
+#endif
+
+// One generation of a block. States whose laneMask is zero keep their rows.
+LIFE_TARGET_CLONES
+static void StepBlock(uint64_t* rows, const uint64_t* laneMask)
+{
+	const int W = LifeBatch::BLOCK;
+	uint64_t bit0[64 * W];
+	uint64_t bit1[64 * W];
+
+	for (int i = 0; i < 64 * W; i++)
+	{
+		uint64_t m = rows[i];
+		uint64_t l = CirculateLeft(m);
+		uint64_t r = CirculateRight(m);
+		bit0[i] = l ^ r ^ m;
+		bit1[i] = ((l | r) & m) | (l & r);
+	}
+
+	for (int i = 0; i < 64; i++)
 	{
-		tempState[0] = evolve(state[0], bit0[64 - 1], bit1[64 - 1], bit0[1], bit1[1]);
-		tempState[64 - 1] = evolve(state[64 - 1], bit0[64 - 2], bit1[64 - 2], bit0[0], bit1[0]);
+		int up = ((i + 64 - 1) % 64) * W;
+		int down = ((i + 1) % 64) * W;
+		uint64_t* current = rows + i * W;
+		for (int l = 0; l < W; l++)
+		{
+			uint64_t old = current[l];
+			uint64_t next = evolve(old, bit0[up + l], bit1[up + l], bit0[down + l], bit1[down + l]);
+			current[l] = (next & laneMask[l]) | (old & ~laneMask[l]);
+		}
 	}
+}
 
-	// Recalculate state from tempState
-	for (int i = start+1; i <= last-1; i++)
+// miss[l] is non-zero unless state l of the block contains `on` and avoids `off`.
+LIFE_TARGET_CLONES
+static void MatchBlock(const uint64_t* rows, const uint64_t* on, const uint64_t* off, uint64_t* miss)
+{
+	const int W = LifeBatch::BLOCK;
+	for (int l = 0; l < W; l++)
 	{
-		state[i] = tempState[i];
+		miss[l] = 0;
 	}
-	if (wrap)
+	for (int i = 0; i < 64; i++)
 	{
-		state[0] = tempState[0];
-		state[64 - 1] = tempState[64 - 1];
+		const uint64_t* current = rows + i * W;
+		for (int l = 0; l < W; l++)
+		{
+			miss[l] |= (on[i] & ~current[l]) | (off[i] & current[l]);
+		}
 	}
-
-	(wrap) ? this->recalculateMinMax() : this->refitMinMax();
-	this->gen++;
 }
 
-void LifeState::run(int gens)
+LifeBatch::LifeBatch(size_t size)
 {
-	assert(gens > 0);
-	for(int i=0; i<gens; ++i)
-	{
-		this->iterate();
-		this->removeGliders();
-	}	
+	this->count = size;
+	size_t blocks = (size + BLOCK - 1) / BLOCK;
+	this->rows.assign(blocks * 64 * BLOCK, 0);
+	this->active.assign(size, 0);
+	this->gens.assign(size, 0);
 }
 
-LifeState LifeState::after(int gens) const
+void LifeBatch::setState(size_t i, const LifeState& s)
 {
-	LifeState result(*this);
-	result.run(gens);
-	return result;
+	assert(i < this->count);
+	for (int r = 0; r < 64; r++)
+	{
+		this->row(i, r) = s.state[r];
+	}
+	this->gens[i] = s.gen;
+	this->active[i] = 1;
 }
 
-// To other objects.
-
-std::string LifeState::toDebugString() const
+LifeState LifeBatch::getState(size_t i) const
 {
-	std::stringstream ss;
-	int i, j;
-
-	for(i = 0; i < 64; i++)
+	assert(i < this->count);
+	LifeState result;
+	for (int r = 0; r < 64; r++)
 	{
-		for(j = 0; j < 64; j++)
-		{
-			char ch;
-			if(this->getCell(j - 32, i - 32) == 0)
-			{
-				bool hor = ((i - 32) % 10 == 0);
-				bool ver = ((j - 32) % 10 == 0);
-				if(hor && ver)  ch = '+';
-				else if(hor) ch = '-';
-				else if(ver) ch = '|';
-				else ch = '.';
-			} else {
-				ch = 'O';
-			}
-			ss << ch;
-		}
-		ss << '\n';
+		result.state[r] = this->row(i, r);
 	}
-	ss << '\n';
-	return ss.str();
+	result.gen = this->gens[i];
+	result.recalculateBounds();
+	return result;
 }
 
-std::string LifeState::toRLE() const
+size_t LifeBatch::runBlock(size_t block, int maxGens, const LifeTarget* target)
 {
-	std::stringstream ss;
-	int eol_count = 0;
+	size_t first = block * BLOCK;
+	uint64_t* rows = &this->rows[block * 64 * BLOCK];
+	uint64_t mask[BLOCK];
+	uint64_t miss[BLOCK];
+	size_t matched = 0;
 
-	for(int j = 0; j < 64; j++)
+	// The lanes past count in the last block are padding: their mask
+	// stays 0 and their gens and active flags don't exist.
+	for (int g = 0; ; g++)
 	{
-		int last_val = -1;
-		int run_count = 0;
-
-		for(uint64_t i = 0; i < 64; i++)
+		for (int l = 0; l < BLOCK; l++)
 		{
-			int val = Get(this->state, i, j);
-
-			// Flush linefeeds if we find a live cell
-			if(val == 1 && eol_count > 0)
-			{
-				if(eol_count > 1)
-				{
-					ss << eol_count;
-				}
-				ss << '$';
-				eol_count = 0;
-			}
+			bool on = (first + l < this->count) && this->active[first + l];
+			mask[l] = on ? ~0ULL : 0ULL;
+		}
 
-			// Flush current run if val changes
-			if (val != last_val)
+		// Checked before every step, so a state that already matches
+		// stops at its current generation.
+		if (target != NULL)
+		{
+			MatchBlock(rows, target->on.state, target->off.state, miss);
+			for (int l = 0; l < BLOCK; l++)
 			{
-				if(run_count > 1)
-				{
-					ss << run_count;
-				}
-				// N.B. last_val can be -1.
-				// Using boolean value of last_val is unreliable.
-				if (last_val == 1)
+				if (mask[l] && miss[l] == 0)
 				{
-					ss << 'o';
+					this->active[first + l] = 0;
+					mask[l] = 0;
+					matched++;
 				}
-				else if (last_val == 0)
-				{
-					ss << 'b';
-				}
-				run_count = 0;
 			}
-			run_count++;
-			last_val = val;
 		}
 
-		// Flush run of live cells at end of line
-		if (last_val == 1)
+		bool any = false;
+		for (int l = 0; l < BLOCK; l++)
 		{
-			if(run_count > 1)
-			{
-				ss << run_count;
-			}
-			ss << 'o';
-			run_count = 0;
+			any = any || mask[l];
 		}
-		eol_count++;
-	}
-
-	// Flush remaining linefeeds to make the height 64.
-	if (eol_count > 0) 
-	{
-		if (eol_count > 1)
+		if (!any || g == maxGens)
 		{
-			ss << eol_count;
+			break;
 		}
-		ss << '$';
-	}
-	return ss.str();
-}
-
-// CellList and LifeLocator related features.
 
-CellList LifeState::toCellList() const
-{
-	CellList clist;
-	for (int y=-32; y<32; y++)
-	{
-		for (int x=-32; x<32; x++)
+		StepBlock(rows, mask);
+		for (int l = 0; l < BLOCK; l++)
 		{
-			if (this->getCell(x, y) == 1)
+			if (mask[l])
 			{
-				Cell c = {x, y};
-				clist.push_back(c);
+				this->gens[first + l]++;
 			}
 		}
 	}
-	return clist;
+	return matched;
 }
 
-LifeState CellList::toLifeState() const
+void LifeBatch::run(int gens)
 {
-	LifeState result;
-	for (CellList::const_iterator it=this->begin(); it != this->end(); ++it)
+	assert(gens > 0);
+	for (size_t block = 0; BLOCK * block < this->count; block++)
 	{
-		result.setCell(it->x, it->y, 1);
+		this->runBlock(block, gens, NULL);
 	}
-	return result;
 }
 
-LifeLocator LifeState::toLifeLocator() const
+size_t LifeBatch::runUntil(const LifeTarget& target, int maxGens)
 {
-	return LifeLocator(*this, LifeState());
+	size_t matched = 0;
+	for (size_t block = 0; BLOCK * block < this->count; block++)
+	{
+		matched += this->runBlock(block, maxGens, &target);
+	}
+	return matched;
 }
 
-LifeLocator::LifeLocator(const LifeLocator& rhs)
+// TranspositionTable: hashes of explored states.
+
+#if __cplusplus >= 201103L
+static inline uint64_t LoadSlot(const std::atomic<uint64_t>& slot)
 {
-	this->on = rhs.on;
-	this->off = rhs.off;
+	return slot.load(std::memory_order_relaxed);
 }
 
-LifeLocator::LifeLocator(const char* rle, int x, int y)
+static inline void StoreSlot(std::atomic<uint64_t>& slot, uint64_t value)
 {
-	this->on = LifeState(rle).transform(x, y).toCellList();
-	this->off = LifeState().toCellList();
+	slot.store(value, std::memory_order_relaxed);
 }
 
-LifeLocator::LifeLocator(const char* rle, int x, int y, int dxx, int dxy, int dyx, int dyy)
+// Fills an empty slot; `seen` gets what the slot holds if it wasn't.
+static inline bool ClaimSlot(std::atomic<uint64_t>& slot, uint64_t value, uint64_t& seen)
 {
-	this->on = LifeState(rle).transform(x, y, dxx, dxy, dyx, dyy).toCellList();
-	this->off = LifeState().toCellList();
+	seen = 0;
+	return slot.compare_exchange_strong(seen, value, std::memory_order_relaxed);
 }
-
-LifeLocator::LifeLocator(const LifeState& on, const LifeState& off)
+#else
+static inline uint64_t LoadSlot(const uint64_t& slot)
 {
-	this->on = on.toCellList();
-	this->off = off.toCellList();
+	return slot;
 }
 
-LifeLocator LifeLocator::withBoundary() const
+static inline void StoreSlot(uint64_t& slot, uint64_t value)
 {
-	LifeLocator result(*this);
-	LifeState on = this->on.toLifeState();
-	LifeState off;
-	for (int y=-1; y<=1; ++y)
-	{
-		for(int x=-1; x<=1; ++x)
-		{
-			off |= on.transform(x, y);
-		}
-	}
-	off &= (~on);
-	result.off = off.toCellList();
-	return result;
+	slot = value;
 }
 
-uint64_t LifeState::locateAtX(const CellList& target, int x, bool on) const
+static inline bool ClaimSlot(uint64_t& slot, uint64_t value, uint64_t& seen)
 {
-	uint64_t locations = ~0ULL;
-
-	for(CellList::const_iterator it = target.begin(); it != target.end(); ++it)
+	seen = slot;
+	if (seen != 0)
 	{
-		int idx = (x + 32 + it->x) % 64;
-		int circulate = (it->y) % 64;
-		// Make 'em positive.
-		idx += ((idx < 0) ? 64 : 0);
-		circulate += ((circulate < 0) ? 64 : 0);
-
-		if (on)
-		{
-			locations &= CirculateRight(this->state[idx], circulate);
-		}
-		else
-		{
-			locations &= CirculateRight(~(this->state[idx]), circulate);
-		}
-
-		if(locations == 0ULL)
-		{
-			break;
-		}
+		return false;
 	}
+	slot = value;
+	return true;
+}
+#endif
 
-	return locations;
+TranspositionTable::TranspositionTable(int log2Size)
+{
+	assert(log2Size >= 2 && log2Size < 48);
+	this->mask = (1ULL << log2Size) - 1;
+#if __cplusplus >= 201103L
+	this->slots = new std::atomic<uint64_t>[this->capacity()];
+#else
+	this->slots = new uint64_t[this->capacity()];
+#endif
+	this->clear();
 }
 
-uint64_t LifeState::locateAtX(const LifeLocator& l, int x) const
+TranspositionTable::~TranspositionTable()
 {
-	uint64_t locations_wanted = this->locateAtX(l.on, x, true);
-	uint64_t locations_unwanted = this->locateAtX(l.off, x, false);
-	return locations_wanted & locations_unwanted;
+	delete[] this->slots;
 }
 
-void LifeState::removeAtX(const CellList& target, int x, uint64_t locations)
+void TranspositionTable::clear()
 {
-	if(locations == 0ULL)
-	{
-		return;
-	}
-	//
-	for(CellList::const_iterator it = target.begin(); it != target.end(); ++it)
+	for (size_t k = 0; k < this->capacity(); k++)
 	{
-		int idx = (x + 32 + it->x) % 64;
-		int circulate = (it->y) % 64;
-		idx += ((idx < 0) ? 64  : 0);
-		circulate += ((circulate < 0) ? 64 : 0);
-		this->state[idx] &= ~CirculateLeft(locations, circulate);
+		StoreSlot(this->slots[k], 0);
 	}
 }
 
-void LifeState::removeAtX(const LifeLocator& l, int x)
+// 0 marks an empty slot, so hash 0 is stored as 1.
+bool TranspositionTable::insert(uint64_t hash)
 {
-	uint64_t locations = this->locateAtX(l, x);
-	this->removeAtX(l.on, x, locations);
+	uint64_t key = (hash != 0) ? hash : 1;
+	size_t base = (size_t)(key & this->mask & ~(uint64_t)(BUCKET - 1));
+	for (int k = 0; k < BUCKET; k++)
+	{
+		uint64_t seen = LoadSlot(this->slots[base + k]);
+		if (seen == 0 && ClaimSlot(this->slots[base + k], key, seen))
+		{
+			return false;
+		}
+		if (seen == key)
+		{
+			return true;
+		}
+	}
+	// The bucket is full: the high bits pick a slot to give up.
+	StoreSlot(this->slots[base + (key >> 62) % BUCKET], key);
+	return false;
 }
 
-void LifeState::removeGliders()
+bool TranspositionTable::contains(uint64_t hash) const
 {
-	// Canonical gliders
-	static const LifeState glider("bo$2bo$3o!", -2, -2);
-	static const LifeLocator glider_locators[4] =
-	{
-		glider.toLifeLocator().withBoundary(), // SE
-		glider.transform(0, 0, 0, -1, 1, 0).toLifeLocator().withBoundary(), // SW
-		glider.transform(0, 0, -1, 0, 0, -1).toLifeLocator().withBoundary(), // NW
-		glider.transform(0, 0, 0, 1, -1, 0).toLifeLocator().withBoundary() // NE
-	};
-	for (size_t i=0; i<4; ++i)
+	uint64_t key = (hash != 0) ? hash : 1;
+	size_t base = (size_t)(key & this->mask & ~(uint64_t)(BUCKET - 1));
+	for (int k = 0; k < BUCKET; k++)
 	{
-		uint64_t locations = this->locateAtX(glider_locators[i], -32);
-		this->removeAtX(glider_locators[i].on, -32, locations);
-		for (int y=-32; y<32; y++)
+		if (LoadSlot(this->slots[base + k]) == key)
 		{
-			if ((locations & (1ULL << (y+32))) != 0)
-			{
-				bool dx, dy;
-				switch(i)
-				{
-					case 0: dx = true; dy = true; break; // SE
-					case 1: dx = false; dy = true; break; // SW
-					case 2: dx = false; dy = false; break; // NW
-					case 3: dx = true; dy = false; break; // NE
-					default: throw; // unreachable
-				}
-				GliderData gd = {-32, y, this->gen, dx, dy};
-				this->gliders.push_back(gd);
-			}
+			return true;
 		}
 	}
-	this->refitMinMax();
+	return false;
 }
 
-LifeState LifeState::locate(const CellList& target, bool on) const
+bool LifeCollision::add(const LifeState& s, int maxPeriod)
 {
-	LifeState locations; 
-	for (int i=this->min; i<=this->max; ++i)
+	LifeState copy = s;
+	copy.setGliderRemoval(GLIDERS_OFF);
+	copy.setSpaceshipCatalog(NULL);
+	StabilityData data = copy.runUntilStable(maxPeriod, maxPeriod);
+	if (!data.stable || data.gen != 0)
 	{
-		uint64_t x_locations = this->locateAtX(target, i-32, on);
-		locations.state[i] = x_locations;
+		return false;
 	}
-	return locations;
+	this->add(s, data.period, data.dx, data.dy);
+	return true;
 }
 
-LifeState LifeState::locate(const LifeLocator& l) const
+// Whether [s1, s1 + l1) and [s2, s2 + l2) meet around the torus.
+static inline bool CircularOverlap(int s1, int l1, int s2, int l2)
 {
-	LifeState wanted_locations = this->locate(l.on, true);
-	LifeState unwanted_locations = this->locate(l.off, false);
-	LifeState locations(wanted_locations);
-	locations &= unwanted_locations;
-	return locations;
+	return ((s2 - s1) & 63) < l1 || ((s1 - s2) & 63) < l2;
 }
 
-void LifeState::remove(const LifeLocator& l)
+// The piece on its own is checked for gliders at the edge the way run()
+// does after every generation, but only when a phase reaches column -32.
+// After 64 periods a ship is back where it started, so if nothing was
+// removed by then nothing ever is.
+void LifeCollision::add(const LifeState& s, int period, int dx, int dy)
 {
-	CellList locations = this->locate(l).toCellList();
-	LifeState object = l.on.toLifeState();
-	for (CellList::iterator it=locations.begin(); it != locations.end(); ++it)
+	assert(period > 0);
+	if (s.isEmpty())
+	{
+		return;
+	}
+	Piece piece = {(int)this->phases.size(), period, dx, dy, -1, std::vector<GliderData>(), false};
+	Phase phase;
+	phase.state = s;
+	phase.state.setGliderRemoval(GLIDERS_OFF);
+	phase.state.setSpaceshipCatalog(NULL);
+	phase.state.setEventSink(NULL);
+	for (int p = 0; p < period; p++)
+	{
+		phase.state.getBoundingBox(phase.x, phase.y, phase.w, phase.h);
+		this->phases.push_back(phase);
+		phase.state.run(1);
+	}
+	int horizon = (dx == 0 && dy == 0) ? period : 64 * period;
+	for (int gen = 1; gen <= horizon && piece.removal < 0; gen++)
 	{
-		*this ^= object.transform(it->x, it->y);
+		int x, y;
+		const Phase& at = this->phaseAt(piece, gen, x, y);
+		if (!CircularOverlap(at.x + x + 32, at.w, 0, 1))
+		{
+			continue;
+		}
+		LifeState alone = at.state.transform(x, y);
+		alone.gen = gen;
+		alone.removeGliders();
+		if (alone.gliderCount > 0)
+		{
+			piece.removal = gen;
+			piece.gliders = alone.getGliders();
+			piece.vanishes = alone.isEmpty();
+		}
 	}
+	this->pieces.push_back(piece);
 }
 
-// LifeTargets: targets with fixed positions.
-LifeTarget::LifeTarget()
+// The phase of the piece at `gen` and where it has moved to, mod 64.
+const LifeCollision::Phase& LifeCollision::phaseAt(const Piece& p, int gen, int& x, int& y) const
 {
-	this->on.clear();
-	this->off.clear();
+	x = (gen / p.period * p.dx) & 63;
+	y = (gen / p.period * p.dy) & 63;
+	return this->phases[p.first + gen % p.period];
 }
 
-// Initialize a `LifeTarget` with only on cells.
-LifeTarget::LifeTarget(const LifeState& s)
+// A piece is there up to the generation it is removed at, when at()
+// removes it along with the rest.
+bool LifeCollision::isPresent(int piece, int gen) const
 {
-	this->on = s;
-	this->off.clear();
+	const Piece& p = this->pieces[piece];
+	return p.removal < 0 || gen <= p.removal;
 }
 
-// Initialize a `LifeTarget` with both on and off targets.
-LifeTarget::LifeTarget(const LifeState& on, const LifeState& off)
+// The boxes, widened by two, rule out most pairs; the rest are checked
+// cell by cell.
+bool LifeCollision::isNear(int a, int b, int gen) const
 {
-	this->on = on;
-	this->off = off;
+	if (!this->isPresent(a, gen) || !this->isPresent(b, gen))
+	{
+		return false;
+	}
+	int ax, ay, bx, by;
+	const Phase& pa = this->phaseAt(this->pieces[a], gen, ax, ay);
+	const Phase& pb = this->phaseAt(this->pieces[b], gen, bx, by);
+	if (!CircularOverlap(pa.x + ax - 2, pa.w + 4, pb.x + bx, pb.w) ||
+		!CircularOverlap(pa.y + ay - 2, pa.h + 4, pb.y + by, pb.h))
+	{
+		return false;
+	}
+	LifeState reach = pa.state.transform(ax, ay).dilate(-2, -2, 5, 5);
+	return !reach.isDisjoint(pb.state.transform(bx, by));
 }
 
-// Return a new LifeTarget with the same ON target
-// and the OFF target surrounding size `size` boundary.
-LifeTarget LifeTarget::withBoundary(int size) const
+int LifeCollision::getContactGen(int maxGens) const
 {
-	assert(size > 0);
-	auto boundary = LifeState::makeRect(-size, -size, size*2+1, size*2+1);
-	auto on = this->on;
-	auto off = (this->on * boundary) - (this->on);
-	return LifeTarget(on, off);
+	for (int gen = 0; gen <= maxGens; gen++)
+	{
+		for (int a = 0; a < this->size(); a++)
+		{
+			if (this->pieces[a].removal == gen && !this->pieces[a].vanishes)
+			{
+				return gen;
+			}
+			for (int b = a + 1; b < this->size(); b++)
+			{
+				if (this->isNear(a, b, gen))
+				{
+					return gen;
+				}
+			}
+		}
+	}
+	return -1;
 }
 
-// See if target matches `LifeState s`.
-inline bool LifeTarget::in(const LifeState& s) const
+LifeState LifeCollision::at(int gen) const
 {
-	return (s.contains(this->on)) &&((~s).contains(this->off));
-}
\ No newline at end of file
+	assert(gen >= 0);
+	LifeState result;
+	for (int k = 0; k < this->size(); k++)
+	{
+		const Piece& p = this->pieces[k];
+		if (this->isPresent(k, gen))
+		{
+			int x, y;
+			result |= this->phaseAt(p, gen, x, y).state.transform(x, y);
+		}
+	}
+	// Gliders the pieces lost on their own come first, as in run().
+	for (int k = 0; k < this->size(); k++)
+	{
+		if (!this->isPresent(k, gen))
+		{
+			const std::vector<GliderData>& gliders = this->pieces[k].gliders;
+			for (size_t n = 0; n < gliders.size(); n++)
+			{
+				result.logGlider(gliders[n]);
+			}
+		}
+	}
+	result.gen = gen;
+	if (gen > 0)
+	{
+		result.removeGliders();
+	}
+	return result;
+}
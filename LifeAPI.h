@@ -7,21 +7,37 @@
 #ifdef _MSC_VER
 	#include <intrin.h>
 	#define __builtin_popcountll __popcnt64
+	static inline int __builtin_ctzll(unsigned long long x)
+	{
+		unsigned long i;
+		_BitScanForward64(&i, x);
+		return (int)i;
+	}
 #endif
 
 // Incredibly, C++03 doesn't have uint64_t.
 #if __cplusplus < 201103L
 	typedef unsigned long long uint64_t;
+	typedef unsigned int uint32_t;
 #else
+	#include <atomic>
 	#include <cinttypes>
+	#include <utility>
 #endif
 
+#include <sstream>
 #include <string>
 #include <vector>
 
 class LifeState;
 class LifeLocator;
 class CellList;
+class LifeGrid;
+class HashLife;
+class LifeBatch;
+class LocatorSet;
+class SpaceshipCatalog;
+class LifeCollision;
 typedef struct { int x; int y; } Cell;
 
 typedef struct
@@ -33,42 +49,342 @@ typedef struct
 	bool dy; // true: +y, false: -y
 } GliderData;
 
-class LifeState
+typedef struct
+{
+	int ship; // Index in the SpaceshipCatalog
+	int x;    // Top-left corner of the bounding box
+	int y;
+	int gen;
+	int dx;   // Direction of travel: -1, 0 or 1
+	int dy;
+} SpaceshipData;
+
+// What LifeState::runUntilStable() found. The state at gen + period is the
+// one at gen moved by (dx, dy); dx = dy = 0 for still lifes and oscillators.
+typedef struct
+{
+	bool stable; // false if maxGens ran out first
+	int gen;     // First generation of the cycle
+	int period;
+	int dx;
+	int dy;
+} StabilityData;
+
+// When LifeState::run() removes gliders escaping across the torus edge.
+enum GliderRemoval
+{
+	GLIDERS_EVERY_GEN, // The default: check the edge every generation
+	GLIDERS_PERIODIC,  // Check a wider band around the edge every few generations
+	GLIDERS_OFF        // Leave gliders alone
+};
+
+// Where LifeStates can also log the gliders and spaceships they remove. A
+// LifeState only holds a pointer to its sink, which its copies share, so
+// one sink per thread can take the events of a whole search while the
+// states stay plain words that copy without allocating.
+class LifeEventSink
+{
+public:
+	std::vector<GliderData> gliders;
+	std::vector<SpaceshipData> spaceships;
+	void clear() { this->gliders.clear(); this->spaceships.clear(); }
+};
+
+// Instruction sets for the iterate() kernel, from slowest to fastest.
+enum SimdLevel
+{
+	SIMD_NONE,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_AVX512
+};
+
+// The eight symmetries of the square, as transform() matrices
+// (x, y) -> (dxx * x + dxy * y, dyx * x + dyy * y), with y pointing down.
+enum Orientation
+{
+	ORIENT_IDENTITY, // (x, y)
+	ORIENT_ROT90,    // (-y, x), clockwise
+	ORIENT_ROT180,   // (-x, -y)
+	ORIENT_ROT270,   // (y, -x)
+	ORIENT_FLIP_X,   // (-x, y)
+	ORIENT_FLIP_Y,   // (x, -y)
+	ORIENT_DIAG,     // (y, x)
+	ORIENT_ANTIDIAG  // (-y, -x)
+};
+
+// Outer-totalistic rules
+
+// A boolean circuit for a truth table over `Bits` inputs, built by Shannon
+// expansion on the top input. Halves that are equal skip the mux, and
+// constant halves fold away, so each rule gets its own reduced circuit.
+template <unsigned Table, int Bits>
+struct LifeRuleCircuit
+{
+	static const unsigned HALF = 1u << (Bits - 1);
+	static const unsigned LO = Table & ((1u << HALF) - 1);
+	static const unsigned HI = Table >> HALF;
+	static inline uint64_t eval(const uint64_t* in)
+	{
+		if (LO == HI)
+		{
+			return LifeRuleCircuit<LO, Bits - 1>::eval(in);
+		}
+		uint64_t lo = LifeRuleCircuit<LO, Bits - 1>::eval(in);
+		uint64_t hi = LifeRuleCircuit<HI, Bits - 1>::eval(in);
+		return (in[Bits - 1] & hi) | (~in[Bits - 1] & lo);
+	}
+};
+
+template <unsigned Table>
+struct LifeRuleCircuit<Table, 0>
+{
+	static inline uint64_t eval(const uint64_t*) { return Table ? ~0ULL : 0ULL; }
+};
+
+// Bit n of Birth (Survival) is set when a dead (live) cell with n live
+// neighbours is alive in the next generation. ConwayLife is B3/S23.
+template <unsigned Birth, unsigned Survival>
+struct LifeRule
+{
+	static const unsigned BIRTH = Birth & 0x1FF;
+	static const unsigned SURVIVAL = Survival & 0x1FF;
+	// Truth table indexed by count + 16 * alive. Counts 9 to 15 can't
+	// happen, so they copy count 8 to let the top input fold away.
+	static const unsigned TABLE =
+		(BIRTH & 0xFF) | ((BIRTH & 0x100) ? 0xFF00u : 0)
+		| (((SURVIVAL & 0xFF) | ((SURVIVAL & 0x100) ? 0xFF00u : 0)) << 16);
+
+	// Same arguments as evolve() in LifeAPI.cpp: the row and the bit0/bit1
+	// counts of the rows on either side of it.
+	static inline uint64_t evolve(uint64_t temp, uint64_t bU0, uint64_t bU1, uint64_t bB0, uint64_t bB1)
+	{
+		uint64_t l = (temp << 1) | (temp >> 63);
+		uint64_t r = (temp >> 1) | (temp << 63);
+		// Exact 4-bit neighbour count: (l + r) + (bU1 bU0) + (bB1 bB0).
+		uint64_t s0 = l ^ r;
+		uint64_t s1 = l & r;
+		uint64_t a0 = bU0 ^ bB0;
+		uint64_t c0 = bU0 & bB0;
+		uint64_t a1 = bU1 ^ bB1 ^ c0;
+		uint64_t a2 = (bU1 & bB1) | (c0 & (bU1 ^ bB1));
+		uint64_t k0 = a0 & s0;
+		uint64_t k1 = (a1 & s1) | (k0 & (a1 ^ s1));
+		uint64_t in[5] = { a0 ^ s0, a1 ^ s1 ^ k0, a2 ^ k1, a2 & k1, temp };
+		return LifeRuleCircuit<TABLE, 5>::eval(in);
+	}
+};
+
+typedef LifeRule<(1 << 3), (1 << 2) | (1 << 3)> ConwayLife;
+typedef LifeRule<(1 << 3) | (1 << 6), (1 << 2) | (1 << 3)> HighLife;
+
+// Parse a B/S rulestring such as "B36/S23" into neighbour count masks.
+// Returns false if the string isn't a valid outer-totalistic rule.
+bool ParseRule(const char* rule, unsigned& birth, unsigned& survival);
+
+#if __cplusplus >= 201103L
+// Compile-time version, for LifeRule<RuleBirth("B36/S23"), RuleSurvival("B36/S23")>.
+constexpr unsigned RuleMask(const char* rule, char section, bool inSection=false)
+{
+	return (*rule == '\0') ? 0u
+		: (*rule == section || *rule == section + ('a' - 'A')) ? RuleMask(rule + 1, section, true)
+		// The other section's letter ends this one, with or without a '/'.
+		: (*rule == '/' || *rule == 'B' || *rule == 'b' || *rule == 'S' || *rule == 's')
+			? RuleMask(rule + 1, section, false)
+		: (inSection && *rule >= '0' && *rule <= '8')
+			? ((1u << (*rule - '0')) | RuleMask(rule + 1, section, true))
+		: RuleMask(rule + 1, section, inSection);
+}
+
+constexpr unsigned RuleBirth(const char* rule) { return RuleMask(rule, 'B'); }
+constexpr unsigned RuleSurvival(const char* rule) { return RuleMask(rule, 'S'); }
+#endif
+
+// Isotropic non-totalistic rules
+
+// A rule in Hensel notation, such as "B2-a/S12" or "B3/S23". The rule is
+// parsed at runtime into a 512-entry table and compiled into a reduced
+// ordered BDD, which is evaluated 64 cells at a time as a list of muxes.
+class IsotropicRule
+{
+public:
+	// Neighbour bits of a neighbourhood index, in Hensel order.
+	// CENTRE is the cell itself.
+	enum { N = 1, NE = 2, E = 4, SE = 8, S = 16, SW = 32, W = 64, NW = 128, CENTRE = 256 };
+	// Rows of cells evaluated per pass over the gate list.
+	enum { CHUNK = 8 };
+
+	IsotropicRule(const char* rule);
+	bool isValid() const { return this->valid; }
+	// Next state of a cell whose neighbourhood has the given bits set.
+	bool get(int neighbourhood) const { return (this->table[neighbourhood >> 6] >> (neighbourhood & 63)) & 1; }
+	bool hasB0() const { return this->get(0); }
+	int getGateCount() const { return (int)this->gates.size(); }
+	// in[v * CHUNK + r] holds input v (a neighbour bit index, 8 for the
+	// centre) for row r. Writes `count` result rows to out.
+	void evaluate(const uint64_t* in, int count, uint64_t* out) const;
+private:
+	enum GateKind { GATE_VAR, GATE_NOT, GATE_AND, GATE_ANDNOT, GATE_OR, GATE_ORNOT, GATE_MUX };
+	// Operands are gate indices, or FALSE_REF / TRUE_REF.
+	enum { FALSE_REF = -1, TRUE_REF = -2 };
+	// A BDD over 9 inputs has fewer than 150 nodes.
+	enum { MAX_GATES = 256 };
+	struct Gate
+	{
+		int kind;
+		int var;
+		int lo;
+		int hi;
+	};
+	bool valid;
+	uint64_t table[8];
+	std::vector<Gate> gates;
+	int output;
+
+	bool parse(const char* rule);
+	void compile();
+};
+
+// Bitwise expressions over LifeStates (a & ~b | c) build a tree of these
+// instead of a LifeState per operator; the tree is evaluated row by row
+// in one loop when it's assigned to a LifeState, and only over the rows
+// its bounds allow. Reductions run on the tree without building a state,
+// and stop as soon as the answer is known. An expression holds references
+// to its LifeState lvalues, so store it in a LifeState, not in auto.
+template <class E>
+class LifeExpr
+{
+public:
+	const E& self() const { return static_cast<const E&>(*this); }
+	bool isEmpty() const;
+	int getPop() const;
+	bool contains(const LifeState& rhs) const;
+	bool isDisjoint(const LifeState& rhs) const;
+	// The rest of LifeState's const API evaluates the expression into a
+	// new LifeState first, so (a & b).toRLE() works as on a state.
+	LifeState toLifeState() const;
+	int getCell(int x, int y) const;
+	int getGen() const { return 0; }
+	int getGliderCount() const { return 0; }
+	int getSpaceshipCount() const { return 0; }
+	std::vector<GliderData> getGliders() const { return std::vector<GliderData>(); }
+	std::vector<SpaceshipData> getSpaceships() const { return std::vector<SpaceshipData>(); }
+	GliderRemoval getGliderRemoval() const { return GLIDERS_EVERY_GEN; }
+	LifeEventSink* getEventSink() const { return NULL; }
+	uint64_t getHash(bool translationInvariant=false) const;
+	void getHash128(uint64_t& lo, uint64_t& hi, bool translationInvariant=false) const;
+	bool getBoundingBox(int& x, int& y, int& w, int& h) const;
+	LifeState transform(int x, int y) const;
+	LifeState transform(int x, int y, int dxx, int dxy, int dyx, int dyy) const;
+	LifeState transform(Orientation orientation, int x=0, int y=0) const;
+	LifeState canonical(Orientation* orientation=NULL) const;
+	uint64_t canonicalHash() const;
+	void run(int gens=1) const; // Runs a copy, like run() on a temporary
+	LifeState after(int gens) const;
+	template <class Rule> LifeState after(int gens) const;
+	LifeState after(const IsotropicRule& rule, int gens) const;
+	std::string toRLE() const;
+	std::string toDebugString() const;
+	CellList toCellList() const;
+	template <class F> F forEachCell(F f) const;
+	LifeLocator toLifeLocator() const;
+	bool isDisjoint(const LifeState& rhs, int dx, int dy) const;
+	bool contains(const LifeState& rhs, int dx, int dy) const;
+	LifeState locate(const CellList& target, bool on) const;
+	LifeState locate(const LifeLocator& l) const;
+	LifeState locate(const LifeLocator& l, int maxMismatches) const;
+	LifeState dilate(int x, int y, int w, int h) const;
+	LifeState andNot(const LifeState& rhs) const;
+	LifeState operator*(const CellList& rhs) const;
+	LifeState operator*(const LifeState& rhs) const;
+};
+
+class LifeState : public LifeExpr<LifeState>
 {
 public:
 	// Public members and static functions
 	static LifeState makeRandomState();
 	static LifeState makeRect(int x, int y, int w, int h);
+	// The iterate() kernel is picked with CPUID on first use.
+	// setSimdLevel() forces a level; it fails if the CPU doesn't support it.
+	// Call it before other threads evolve states: one running meanwhile may
+	// take a step with either kernel, which gives the same result.
+	static SimdLevel getSimdLevel();
+	static bool setSimdLevel(SimdLevel level);
 	// Initializers
 	LifeState();
-	LifeState(const LifeState& s);
 	LifeState(const char* rle);
 	LifeState(const char* rle, int x, int y) { *this = LifeState(rle).transform(x, y); }
 	LifeState(const char* rle, int x, int y, int dxx, int dxy, int dyx, int dyy)
 	{ *this = LifeState(rle).transform(x, y, dxx, dxy, dyx, dyy); }
-	// Operators
+#if __cplusplus >= 201103L
+	// A LifeState owns no memory, so a move is a copy; these stay trivial.
+	LifeState(const LifeState&) = default;
+	LifeState(LifeState&&) = default;
+	LifeState& operator=(const LifeState&) = default;
+	LifeState& operator=(LifeState&&) = default;
+#endif
+	// dst = a op b without a temporary; dst may be a or b. AND and AND NOT
+	// find the exact bounds in the same pass, OR and XOR merge the inputs'.
+	static inline void andInto(LifeState& dst, const LifeState& a, const LifeState& b);
+	static inline void orInto(LifeState& dst, const LifeState& a, const LifeState& b);
+	static inline void xorInto(LifeState& dst, const LifeState& a, const LifeState& b);
+	static inline void andNotInto(LifeState& dst, const LifeState& a, const LifeState& b);
+	// *this - rhs in one pass.
+	inline LifeState andNot(const LifeState& rhs) const;
+	// Operators. ~, &, |, ^, +, - and == are LifeExpr templates, below.
 	inline void operator&=(const LifeState& rhs);
 	inline void operator|=(const LifeState& rhs);
 	inline void operator^=(const LifeState& rhs);
 	inline void operator+=(const LifeState& rhs);
 	inline void operator-=(const LifeState& rhs);
-	inline bool operator==(const LifeState& rhs) const;
-	inline bool operator!=(const LifeState& rhs) const;
-	inline LifeState operator~() const;
-	inline LifeState operator&(const LifeState& rhs) const;
-	inline LifeState operator|(const LifeState& rhs) const;
-	inline LifeState operator^(const LifeState& rhs) const;
-	inline LifeState operator+(const LifeState& rhs) const;
-	inline LifeState operator-(const LifeState& rhs) const;
+	template <class E> LifeState(const LifeExpr<E>& e);
+	template <class E> LifeState& operator=(const LifeExpr<E>& e);
+	template <class E> void operator&=(const LifeExpr<E>& e);
+	template <class E> void operator|=(const LifeExpr<E>& e);
+	template <class E> void operator^=(const LifeExpr<E>& e);
+	template <class E> void operator-=(const LifeExpr<E>& e);
+	// Expression leaf: row i, and the rows and columns that may be live.
+	uint64_t word(int i) const { return this->state[i]; }
+	uint64_t rowsBound() const { return this->rows; }
+	uint64_t colsBound() const { return this->cols; }
 	LifeState operator*(const CellList& rhs) const;
 	LifeState operator*(const LifeState& rhs) const;
+	// Same as *this * (w x h rectangle at (x, y)), in O(log w + log h) passes.
+	LifeState dilate(int x, int y, int w, int h) const;
 	// Get-Set functions
 	void setCell(int x, int y, int val);
 	int getCell(int x, int y) const;
 	int getPop() const;
 	int getGen() const { return this->gen; }
-	std::vector<GliderData> getGliders() const { return this->gliders; }
-	uint64_t getHash() const;
+	// Gliders and spaceships removed since the last clear(). A state keeps
+	// the records of the first GLIDER_RECORDS and SPACESHIP_RECORDS itself;
+	// the counts go on past them. An event sink, if one is set, also gets
+	// every record, from this state and any other using it.
+	static const int GLIDER_RECORDS = 8;
+	static const int SPACESHIP_RECORDS = 4;
+	int getGliderCount() const { return this->gliderCount; }
+	int getSpaceshipCount() const { return this->spaceshipCount; }
+	void setEventSink(LifeEventSink* sink) { this->sink = sink; }
+	LifeEventSink* getEventSink() const { return this->sink; }
+	std::vector<GliderData> getGliders() const
+	{
+		int n = this->gliderCount;
+		if (n > GLIDER_RECORDS) n = GLIDER_RECORDS;
+		return std::vector<GliderData>(this->gliders, this->gliders + n);
+	}
+	// A strong hash: the XOR of rowHash() over the rows, so a caller that
+	// changes a few rows can update it without rehashing the rest. The
+	// translation-invariant hash starts the pattern past its longest empty
+	// runs of rows and columns, so it is the same wherever a copy sits.
+	uint64_t getHash(bool translationInvariant=false) const;
+	void getHash128(uint64_t& lo, uint64_t& hi, bool translationInvariant=false) const;
+	// The share of row i (x = i - 32) in the hash; 0 for an empty row.
+	// Seed 1 gives the high half of getHash128().
+	static uint64_t rowHash(int i, uint64_t word, int seed=0);
+	// The smallest box (x, y, w, h) holding every live cell. On the torus it
+	// may wrap: x + w can run past 31. Returns false for an empty state.
+	bool getBoundingBox(int& x, int& y, int& w, int& h) const;
 	// Other utility functions.
 	void clear();
 	// In-place transformations.
@@ -76,13 +392,50 @@ public:
 	// Out-place transformations
 	LifeState transform(int x, int y) const; // Optimized version for simple move
 	LifeState transform(int x, int y, int dxx, int dxy, int dyx, int dyy) const;
+	// Rotations and reflections are a bit-matrix transpose and bit reversals.
+	LifeState transform(Orientation orientation, int x=0, int y=0) const;
+	// The least of the pattern's eight orientations, each moved so its
+	// bounding box starts at (-32, -32), compared row word by row word.
+	// Copies that differ by a symmetry and a translation give the same
+	// state; `orientation` gets the one that was picked.
+	LifeState canonical(Orientation* orientation=NULL) const;
+	uint64_t canonicalHash() const { return this->canonical().getHash(); }
 	// Iteration
 	void run(int gens=1);
 	LifeState after(int gens) const; // An out-of-place version of run
+	// Runs until the pattern repeats itself, possibly moved, within
+	// maxPeriod generations, or for maxGens generations at most. Stops at
+	// the generation that proves the cycle, one period past its start.
+	StabilityData runUntilStable(int maxGens, int maxPeriod=16);
+	// Glider removal in run(). The checks are skipped while no live cell is
+	// near the edge, so GLIDERS_EVERY_GEN only costs anything there.
+	void setGliderRemoval(GliderRemoval mode, int period=8);
+	GliderRemoval getGliderRemoval() const { return this->gliderRemoval; }
+	// Spaceships in `catalog` that cross the torus edge are removed and
+	// logged like gliders. With a catalog attached, run() checks every
+	// generation; the catalog has to outlive the state.
+	void setSpaceshipCatalog(const SpaceshipCatalog* catalog) { this->catalog = catalog; }
+	int removeSpaceships(const SpaceshipCatalog& catalog);
+	std::vector<SpaceshipData> getSpaceships() const
+	{
+		int n = this->spaceshipCount;
+		if (n > SPACESHIP_RECORDS) n = SPACESHIP_RECORDS;
+		return std::vector<SpaceshipData>(this->spaceships, this->spaceships + n);
+	}
+	// Run under another LifeRule, e.g. s.run<HighLife>(10). Only
+	// run<ConwayLife>() removes escaping gliders.
+	template <class Rule> void run(int gens=1);
+	template <class Rule> LifeState after(int gens) const;
+	// Run under a Hensel notation rule, e.g. s.run(IsotropicRule("B2-a/S12")).
+	void run(const IsotropicRule& rule, int gens=1);
+	LifeState after(const IsotropicRule& rule, int gens) const;
 	// Conversion to other objects
 	std::string toRLE() const;
 	std::string toDebugString() const;
 	CellList toCellList() const;
+	// Calls f(x, y) for every live cell, a column at a time, scanning only
+	// the set bits of the live rows. Returns f, like std::for_each.
+	template <class F> F forEachCell(F f) const;
 	LifeLocator toLifeLocator() const;
 	// Pattern recognintion. dx and dy are the relative location OF the rhs.
 	bool isDisjoint(const LifeState& rhs, int dx=0, int dy=0) const;
@@ -90,38 +443,95 @@ public:
 	// More pattern recognition.
 	LifeState locate(const CellList& target, bool on) const;
 	LifeState locate(const LifeLocator& l) const;
+	// Positions where at most `maxMismatches` cells of `l` disagree.
+	LifeState locate(const LifeLocator& l, int maxMismatches) const;
 	void remove(const LifeLocator& l);
 private:
+	friend class LifeGrid;
+	friend class HashLife;
+	friend class LifeBatch;
+	friend class LocatorSet;
+	friend class LifeCollision;
 	// Private Members
 	int gen;
-	int min;
-	int max;
+	// Bit i of rows is set if state[i] may be nonzero, and bit j of cols if
+	// bit j of any row may be set. Both are exact after recalculateBounds()
+	// and iterate(); setCell() and removals only keep them a superset.
+	uint64_t rows;
+	uint64_t cols;
 	uint64_t state[64];
-	std::vector<GliderData> gliders;
-	// Min-Max-related functions
-	inline void expandMinMax();
-	void refitMinMax();
-	void recalculateMinMax();
-	// Iterations.
+	GliderRemoval gliderRemoval;
+	int gliderPeriod;
+	const SpaceshipCatalog* catalog;
+	LifeEventSink* sink;
+	int gliderCount;
+	int spaceshipCount;
+	GliderData gliders[GLIDER_RECORDS];
+	SpaceshipData spaceships[SPACESHIP_RECORDS];
+	void logGlider(const GliderData& gd);
+	void logSpaceship(const SpaceshipData& data);
+	// Evaluates an expression into the rows and bounds only.
+	template <class E> void assign(const LifeExpr<E>& e);
+	// Bounds-related functions
+	void refitBounds(int start, int length);
+	void refitBounds();
+	void recalculateBounds();
+	// Iterations. A kernel updates rows start + 1 ... last - 1 from rows
+	// start ... last, or the whole torus if wrap is set.
+	typedef void (*RowKernel)(uint64_t* state, int start, int last, bool wrap);
 	void iterate();
+	void iterate(RowKernel kernel, bool full);
+	void iterateFused(int gens);
+	template <class Rule> void iterate();
+	template <class Rule> static void iterateRows(uint64_t* state, int start, int last, bool wrap);
+	void iterate(const IsotropicRule& rule);
 	// Transformations
-	void circulateUp(int k);
 	void reverseRows(int firstRow, int lastRow);
 	void flipX();
+	void flipY();
+	void transpose();
+	void moveToCorner();
+	// Translation-invariant normalization: the row (xs) and bit (ys)
+	// positions where a normal form can start the pattern, and the hash
+	// with the pattern started at (dx, dy).
+	void getNormalStarts(uint64_t& xs, uint64_t& ys, bool narrow) const;
+	void getNormalHash(uint64_t& lo, uint64_t& hi, int& dx, int& dy) const;
+	void hashFrom(int dx, int dy, uint64_t& lo, uint64_t& hi) const;
 	// Locator related functions.
 	uint64_t locateAtX(const CellList& target, int x, bool on) const;
 	uint64_t locateAtX(const LifeLocator& l, int x) const;
+	uint64_t locateAtX(const LifeLocator& l, int x, int maxMismatches) const;
 	void removeAtX(const CellList& target, int x, uint64_t filter);
 	void removeAtX(const LifeLocator& l, int x);
 	void removeGliders();
+	void removeGlidersInBand(int width);
+	bool removeGlidersAt(const LifeLocator& l, int direction, int x);
 };
 
 class CellList: public std::vector<Cell>
 {
 public:
+	CellList() {}
+	// The live cells of an RLE, with its top-left corner at (x, y).
+	explicit CellList(const char* rle, int x=0, int y=0);
 	LifeState toLifeState() const;
 };
 
+// Writes cells as RLE runs, row by row; the toRLE() methods share it.
+class RLEWriter
+{
+public:
+	RLEWriter() : lastVal(-1), runCount(0), eolCount(0) {}
+	void cell(int val);
+	void endRow();
+	std::string finish();
+private:
+	std::stringstream ss;
+	int lastVal;
+	int runCount;
+	int eolCount;
+};
+
 class LifeLocator
 {
 public:
@@ -130,9 +540,33 @@ public:
 	LifeLocator(const char* rle, int x, int y, int dxx, int dxy, int dyx, int dyy);
 	LifeLocator(const LifeState& on, const LifeState& off);
 	LifeLocator withBoundary() const;
+	// The constructors compile the cells into per-row tests. locate() and
+	// remove() compile them again if `on` or `off` changed since, which
+	// writes to the locator: compile() first to share it between threads.
+	void compile() const;
 	// Members
 	CellList on;
 	CellList off;
+private:
+	friend class LifeState;
+	// Columns compared per pass of locate().
+	static const int LANES = 8;
+	// The cells of one row offset and polarity. `shifts` holds their y
+	// offsets mod 64, from `first`. ON rows come before OFF rows.
+	struct Row
+	{
+		int dx;
+		bool on;
+		int first;
+		int count;
+	};
+	mutable std::vector<Row> rows;
+	mutable std::vector<int> shifts;
+	// The cells `rows` was compiled from.
+	mutable CellList compiledOn;
+	mutable CellList compiledOff;
+	void refresh() const;
+	bool matchLanes(const uint64_t* columns, int base, uint64_t* acc) const;
 };
 
 // Targets with a fixed position.
@@ -145,113 +579,1143 @@ public:
     LifeTarget withBoundary(int size=1) const;
     inline bool in(const LifeState& s) const;
 private:
+    friend class LifeBatch;
     LifeState on;
     LifeState off;
 };
 
+// A library of LifeLocators matched in one sweep. Their cells are
+// compiled into one prefix tree of cell tests, ON tests first and then
+// the tests most locators share, so locators with cells in common share
+// the row fetches, shifts and partial ANDs of those cells, and a branch
+// that matches nowhere in a column is skipped as a whole.
+class LocatorSet
+{
+public:
+	LocatorSet() : maxDepth(0) {}
+	// Returns the locator's index. Each add recompiles the tree, so add
+	// a whole library at once where possible; that returns the first index.
+	int add(const LifeLocator& l);
+	int add(const std::vector<LifeLocator>& ls);
+	int size() const { return (int)this->locators.size(); }
+	int getNodeCount() const { return (int)this->nodes.size(); }
+	const LifeLocator& operator[](int i) const { return this->locators[i]; }
+	// matches[i] gets s.locate((*this)[i]).
+	void locate(const LifeState& s, std::vector<LifeState>& matches) const;
+	std::vector<LifeState> locate(const LifeState& s) const;
+private:
+	friend class LifeState;
+	// One cell test: bit y of the row at x + dx, shifted by dy, is set
+	// (on) or clear. `skip` is the node after this one's subtree.
+	struct Node
+	{
+		int dx;
+		int dy;
+		bool on;
+		int depth;
+		int skip;
+		int firstLocator;
+		int locatorCount;
+	};
+	std::vector<LifeLocator> locators;
+	std::vector<Node> nodes;
+	std::vector<int> nodeLocators;
+	int maxDepth;
+
+	void compile();
+	// Adds (locator, match bits) for every locator that matches in row x
+	// within `filter`. `acc` needs maxDepth + 1 words.
+	void matchColumn(const uint64_t* state, int x, uint64_t filter, uint64_t* acc,
+	                 std::vector<std::pair<int, uint64_t> >& hits) const;
+};
+
+// A set of spaceships, each in all of its phases and orientations, as a
+// LocatorSet of their shapes with a ring of OFF cells around them.
+class SpaceshipCatalog
+{
+public:
+	SpaceshipCatalog() : band(0) {}
+	// Add a ship from one of its phases. It must come back to the same
+	// shape, moved, after `period` generations. Returns the ship's index,
+	// or -1 if it doesn't.
+	int add(const char* rle, int period);
+	// The glider, LWSS, MWSS and HWSS, as ships 0 to 3.
+	void addStandardShips();
+	int size() const { return (int)this->ships.size(); }
+	int getShapeCount() const { return (int)this->shapes.size(); }
+	int getNodeCount() const { return this->locators.getNodeCount(); }
+	// Columns either side of the edge that a ship can straddle.
+	int getBand() const { return this->band; }
+private:
+	friend class LifeState;
+	struct Ship
+	{
+		int dx;
+		int dy;
+	};
+	// Shape i is locators[i], with its cells relative to the top-left
+	// corner of its bounding box.
+	struct Shape
+	{
+		int ship;
+		int dx;
+		int dy;
+	};
+	std::vector<Ship> ships;
+	std::vector<Shape> shapes;
+	LocatorSet locators;
+	int band;
+
+	bool addShape(const LifeState& s, int ship, int dx, int dy, std::vector<LifeLocator>& added);
+};
+
+// A fixed-size set of state hashes that threads can share, for skipping
+// states a search has already explored. A hash goes in one of the four
+// slots of its bucket; when the bucket is full it replaces one, so old
+// entries are forgotten instead of the table growing. Only hashes are
+// stored: two states with the same 64-bit hash count as the same state.
+class TranspositionTable
+{
+public:
+	// 2^log2Size slots, at least one bucket.
+	explicit TranspositionTable(int log2Size);
+	~TranspositionTable();
+	// Records the hash. Returns true if it was already there.
+	bool insert(uint64_t hash);
+	bool contains(uint64_t hash) const;
+	void clear();
+	size_t capacity() const { return (size_t)this->mask + 1; }
+private:
+	static const int BUCKET = 4;
+#if __cplusplus >= 201103L
+	std::atomic<uint64_t>* slots;
+#else
+	uint64_t* slots; // Not thread-safe without C++11 atomics.
+#endif
+	uint64_t mask;
+	TranspositionTable(const TranspositionTable&);
+	TranspositionTable& operator=(const TranspositionTable&);
+};
+
+// The pieces of a collision, each a still life, oscillator or spaceship
+// followed on its own from one period of its phases. Until two pieces come
+// within two cells of each other neither affects the other, so a search
+// can start the merged state at the first contact, and drop pieces that
+// never meet without running a generation. Pieces move around the torus
+// as they would in run() with the default settings: ships wrap, and a
+// glider is gone from the generation removeGliders() would take it.
+class LifeCollision
+{
+public:
+	// Adds a pattern that comes back to itself, possibly moved, within
+	// maxPeriod generations. Returns false, adding nothing, if it doesn't.
+	bool add(const LifeState& s, int maxPeriod=16);
+	// Adds a pattern known to come back moved by (dx, dy) every `period`
+	// generations. Empty patterns are ignored.
+	void add(const LifeState& s, int period, int dx, int dy);
+	int size() const { return (int)this->pieces.size(); }
+	void clear() { this->pieces.clear(); this->phases.clear(); }
+	// The first generation at which two pieces are within two cells of
+	// each other, or -1 if none are up to maxGens. A piece that run()
+	// would only partly remove counts as a contact at that generation.
+	int getContactGen(int maxGens) const;
+	// The pieces at generation `gen` in one state, with run()'s glider
+	// removal for that generation applied. Up to the contact generation it
+	// is what running them together from generation 0 gives.
+	LifeState at(int gen) const;
+private:
+	// Phase p of a piece is phases[first + p]; x, y, w and h are the
+	// bounding box of each phase.
+	struct Phase
+	{
+		LifeState state;
+		int x;
+		int y;
+		int w;
+		int h;
+	};
+	// removal is the generation at which removeGliders() first takes
+	// `gliders` gliders from the piece on its own, or -1 if it never does.
+	struct Piece
+	{
+		int first;
+		int period;
+		int dx;
+		int dy;
+		int removal;
+		std::vector<GliderData> gliders; // Removed at `removal`
+		bool vanishes;
+	};
+	std::vector<Piece> pieces;
+	std::vector<Phase> phases;
+
+	const Phase& phaseAt(const Piece& p, int gen, int& x, int& y) const;
+	bool isPresent(int piece, int gen) const;
+	bool isNear(int a, int b, int gen) const;
+};
+
+// A width x height plane of dead cells beyond its edges, stored as 64x64
+// tiles. Cell (0, 0) is the top-left corner. Only tiles whose 3x3 tile
+// neighbourhood changed in the last generation are stepped, so sparse
+// reactions cost about as much as the tiles they occupy.
+class LifeGrid
+{
+public:
+	LifeGrid(int width, int height);
+	int getWidth() const { return this->width; }
+	int getHeight() const { return this->height; }
+	int getGen() const { return this->gen; }
+	void setCell(int x, int y, int val);
+	int getCell(int x, int y) const;
+	int getPop() const;
+	void clear();
+	void run(int gens=1);
+	// OR a LifeState into the grid with the state's (0, 0) at (x, y).
+	void join(const LifeState& s, int x, int y);
+	// The 64x64 window whose (0, 0) is at (x, y).
+	LifeState toLifeState(int x, int y) const;
+private:
+	int width;
+	int height;
+	int tilesX;
+	int tilesY;
+	int gen;
+	std::vector<uint64_t> tiles; // 64 columns per tile, row-major tiles
+	std::vector<char> changed; // Changed in the last generation (or set by hand)
+	std::vector<int> changedList;
+	std::vector<char> scheduled; // Scratch space for step()
+	uint64_t* tile(int tx, int ty) { return &this->tiles[64 * (ty * this->tilesX + tx)]; }
+	const uint64_t* tile(int tx, int ty) const { return &this->tiles[64 * (ty * this->tilesX + tx)]; }
+	void markChanged(int tx, int ty);
+	uint64_t rowMask(int tileY) const;
+	uint64_t column(int x, int tileY) const;
+	uint64_t getColumn(int x, int y) const;
+	void orColumn(int x, int y, uint64_t bits);
+	void step();
+	void stepTile(int tx, int ty, uint64_t* result) const;
+};
+
+// An unbounded plane stored as a memoized quadtree (HashLife). step(k)
+// jumps 2^k generations at once. Unlike LifeState there is no torus and
+// no glider removal: escaping gliders just fly away.
+// The node store is soft-bounded by maxNodes: when a step starts with more
+// nodes than that, everything not reachable from the current pattern is
+// evicted, least recently used first, down to half the budget.
+class HashLife
+{
+public:
+	HashLife(size_t maxNodes=(1 << 22));
+	HashLife(const LifeState& s, size_t maxNodes=(1 << 22));
+	void setState(const LifeState& s);
+	void step(int k); // Advance 2^k generations, k < 60
+	void run(int gens=1);
+	long long getGen() const { return this->gen; }
+	long long getPop() const;
+	size_t getNodeCount() const { return this->nodes.size(); }
+	// The 64x64 window whose (0, 0) is at (x, y).
+	LifeState toLifeState(int x=0, int y=0) const;
+	std::string toRLE() const;
+private:
+	struct Node
+	{
+		int nw, ne, sw, se; // Children, or -1 for the two leaf cells.
+		int level; // Covers 2^level x 2^level cells
+		long long pop;
+		int result; // Memoized successor(this, resultStep), or -1
+		int resultStep;
+		unsigned lastUsed;
+	};
+	std::vector<Node> nodes;
+	std::vector<int> table; // Open addressing hash of the nodes, -1 if free
+	std::vector<int> emptyNodes; // The empty node of each level
+	size_t maxNodes;
+	unsigned clock;
+	int root;
+	long long gen;
+	void reset();
+	int join(int nw, int ne, int sw, int se);
+	int empty(int level);
+	int build(const LifeState& s, int level, int x, int y);
+	int centre(int n);
+	int expand(int n);
+	bool isCentred(int n) const;
+	int cellAt(int n, int x, int y) const;
+	int successor(int n, int k);
+	void collect();
+	void rehash(size_t size);
+	void extract(int n, long long x, long long y, int wx, int wy, LifeState& result) const;
+};
+
+// Many LifeStates evolved in lockstep. The rows are stored
+// structure-of-arrays in blocks of BLOCK states ([block][row][state]),
+// so every row operation runs across states with full-width SIMD, and
+// each block goes through all of its generations while it is in L1.
+// States that are not active are left as they are. Batched states have
+// no bounds tracking and no glider removal.
+class LifeBatch
+{
+public:
+	enum { BLOCK = 16 };
+	LifeBatch(size_t size=0);
+	size_t size() const { return this->count; }
+	void setState(size_t i, const LifeState& s); // Also activates state i
+	LifeState getState(size_t i) const;
+	int getGen(size_t i) const { return this->gens[i]; }
+	bool isActive(size_t i) const { return this->active[i] != 0; }
+	void setActive(size_t i, bool active) { this->active[i] = active; }
+	void run(int gens=1);
+	// Run the active states for up to maxGens generations. A state that
+	// matches `target` after some generation stops there and becomes
+	// inactive. Returns the number of states that matched.
+	size_t runUntil(const LifeTarget& target, int maxGens);
+private:
+	size_t count;
+	std::vector<uint64_t> rows;
+	std::vector<char> active;
+	std::vector<int> gens;
+	uint64_t& row(size_t i, int r) { return this->rows[((i / BLOCK) * 64 + r) * BLOCK + i % BLOCK]; }
+	uint64_t row(size_t i, int r) const { return this->rows[((i / BLOCK) * 64 + r) * BLOCK + i % BLOCK]; }
+	size_t runBlock(size_t block, int maxGens, const LifeTarget* target);
+};
+
 // Inline operators
 
-inline void LifeState::operator&=(const LifeState& rhs)
+// Expression nodes keep other nodes, which are a few references in size,
+// by value. LifeState lvalues are kept by reference and temporaries by
+// value (LifeStateValue, below). Without rvalue references a temporary
+// can't be told apart, so before C++11 every LifeState is copied.
+template <class E> struct LifeExprOperand { typedef E type; };
+#if __cplusplus >= 201103L
+template <> struct LifeExprOperand<LifeState> { typedef const LifeState& type; };
+#endif
+
+template <class E>
+class LifeNot : public LifeExpr<LifeNot<E> >
+{
+public:
+	explicit LifeNot(const E& e) : e(e) {}
+	uint64_t word(int i) const { return ~this->e.word(i); }
+	uint64_t rowsBound() const { return ~0ULL; }
+	uint64_t colsBound() const { return ~0ULL; }
+private:
+	typename LifeExprOperand<E>::type e;
+};
+
+// Op::apply combines two rows; Op::bound combines the operands' bounds.
+struct LifeOpAnd
+{
+	static uint64_t apply(uint64_t a, uint64_t b) { return a & b; }
+	static uint64_t bound(uint64_t a, uint64_t b) { return a & b; }
+};
+struct LifeOpOr
+{
+	static uint64_t apply(uint64_t a, uint64_t b) { return a | b; }
+	static uint64_t bound(uint64_t a, uint64_t b) { return a | b; }
+};
+struct LifeOpXor
+{
+	static uint64_t apply(uint64_t a, uint64_t b) { return a ^ b; }
+	static uint64_t bound(uint64_t a, uint64_t b) { return a | b; }
+};
+struct LifeOpAndNot
+{
+	static uint64_t apply(uint64_t a, uint64_t b) { return a & ~b; }
+	static uint64_t bound(uint64_t a, uint64_t) { return a; }
+};
+
+template <class Op, class L, class R>
+class LifeBinary : public LifeExpr<LifeBinary<Op, L, R> >
+{
+public:
+	LifeBinary(const L& l, const R& r) : l(l), r(r) {}
+	uint64_t word(int i) const { return Op::apply(this->l.word(i), this->r.word(i)); }
+	uint64_t rowsBound() const { return Op::bound(this->l.rowsBound(), this->r.rowsBound()); }
+	uint64_t colsBound() const { return Op::bound(this->l.colsBound(), this->r.colsBound()); }
+private:
+	typename LifeExprOperand<L>::type l;
+	typename LifeExprOperand<R>::type r;
+};
+
+template <class E>
+inline LifeNot<E> operator~(const LifeExpr<E>& e)
+{
+	return LifeNot<E>(e.self());
+}
+
+template <class L, class R>
+inline LifeBinary<LifeOpAnd, L, R> operator&(const LifeExpr<L>& l, const LifeExpr<R>& r)
+{
+	return LifeBinary<LifeOpAnd, L, R>(l.self(), r.self());
+}
+
+template <class L, class R>
+inline LifeBinary<LifeOpOr, L, R> operator|(const LifeExpr<L>& l, const LifeExpr<R>& r)
 {
-    for (int i=0; i < 64; i++)
+	return LifeBinary<LifeOpOr, L, R>(l.self(), r.self());
+}
+
+template <class L, class R>
+inline LifeBinary<LifeOpXor, L, R> operator^(const LifeExpr<L>& l, const LifeExpr<R>& r)
+{
+	return LifeBinary<LifeOpXor, L, R>(l.self(), r.self());
+}
+
+template <class L, class R>
+inline LifeBinary<LifeOpOr, L, R> operator+(const LifeExpr<L>& l, const LifeExpr<R>& r)
+{
+	return LifeBinary<LifeOpOr, L, R>(l.self(), r.self());
+}
+
+template <class L, class R>
+inline LifeBinary<LifeOpAndNot, L, R> operator-(const LifeExpr<L>& l, const LifeExpr<R>& r)
+{
+	return LifeBinary<LifeOpAndNot, L, R>(l.self(), r.self());
+}
+
+#if __cplusplus >= 201103L
+// A LifeState temporary in an expression, held by value so the expression
+// can't outlive it: `auto e = s & LifeState::makeRect(0, 0, 8, 8);` stays
+// valid. The overloads take const rvalues too, so no temporary is held by
+// reference.
+class LifeStateValue : public LifeExpr<LifeStateValue>
+{
+public:
+	explicit LifeStateValue(const LifeState& s) : s(s) {}
+	uint64_t word(int i) const { return this->s.word(i); }
+	uint64_t rowsBound() const { return this->s.rowsBound(); }
+	uint64_t colsBound() const { return this->s.colsBound(); }
+private:
+	LifeState s;
+};
+
+inline LifeNot<LifeStateValue> operator~(const LifeState&& e)
+{
+	return LifeNot<LifeStateValue>(LifeStateValue(e));
+}
+
+#define LIFE_RVALUE_OPERATOR(OP, Op) \
+	template <class R> \
+	inline LifeBinary<Op, LifeStateValue, R> operator OP(const LifeState&& l, const LifeExpr<R>& r) \
+	{ \
+		return LifeBinary<Op, LifeStateValue, R>(LifeStateValue(l), r.self()); \
+	} \
+	template <class L> \
+	inline LifeBinary<Op, L, LifeStateValue> operator OP(const LifeExpr<L>& l, const LifeState&& r) \
+	{ \
+		return LifeBinary<Op, L, LifeStateValue>(l.self(), LifeStateValue(r)); \
+	} \
+	inline LifeBinary<Op, LifeStateValue, LifeStateValue> operator OP(const LifeState&& l, const LifeState&& r) \
+	{ \
+		return LifeBinary<Op, LifeStateValue, LifeStateValue>(LifeStateValue(l), LifeStateValue(r)); \
+	}
+
+LIFE_RVALUE_OPERATOR(&, LifeOpAnd)
+LIFE_RVALUE_OPERATOR(|, LifeOpOr)
+LIFE_RVALUE_OPERATOR(^, LifeOpXor)
+LIFE_RVALUE_OPERATOR(+, LifeOpOr)
+LIFE_RVALUE_OPERATOR(-, LifeOpAndNot)
+#undef LIFE_RVALUE_OPERATOR
+#endif
+
+// Rows outside both bounds are empty on both sides.
+template <class L, class R>
+inline bool operator==(const LifeExpr<L>& l, const LifeExpr<R>& r)
+{
+	for (uint64_t rows = l.self().rowsBound() | r.self().rowsBound(); rows != 0; rows &= rows - 1)
 	{
-        this->state[i] &= rhs.state[i];
-    }
-    this->recalculateMinMax();
+		int i = __builtin_ctzll(rows);
+		if (l.self().word(i) != r.self().word(i)) return false;
+	}
+	return true;
 }
 
-inline void LifeState::operator^=(const LifeState& rhs)
+template <class L, class R>
+inline bool operator!=(const LifeExpr<L>& l, const LifeExpr<R>& r)
+{
+	return !(l == r);
+}
+
+template <class E>
+bool LifeExpr<E>::isEmpty() const
 {
-    for (int i=0; i < 64; i++)
+	for (uint64_t rows = this->self().rowsBound(); rows != 0; rows &= rows - 1)
 	{
-        this->state[i] ^= rhs.state[i];
-    }
-    this->recalculateMinMax();
+		if (this->self().word(__builtin_ctzll(rows)) != 0) return false;
+	}
+	return true;
 }
 
-inline void LifeState::operator|=(const LifeState& rhs)
+template <class E>
+int LifeExpr<E>::getPop() const
 {
-    for (int i=0; i < 64; i++)
+	int pop = 0;
+	for (uint64_t rows = this->self().rowsBound(); rows != 0; rows &= rows - 1)
 	{
-        this->state[i] |= rhs.state[i];
-    }
-    this->recalculateMinMax();
+		pop += __builtin_popcountll(this->self().word(__builtin_ctzll(rows)));
+	}
+	return pop;
 }
 
-inline void LifeState::operator+=(const LifeState& rhs)
+template <class E>
+bool LifeExpr<E>::contains(const LifeState& rhs) const
 {
-	*this |= rhs;
+	for (uint64_t rows = rhs.rowsBound(); rows != 0; rows &= rows - 1)
+	{
+		int i = __builtin_ctzll(rows);
+		if ((this->self().word(i) & rhs.word(i)) != rhs.word(i)) return false;
+	}
+	return true;
 }
 
-inline void LifeState::operator-=(const LifeState& rhs)
+template <class E>
+bool LifeExpr<E>::isDisjoint(const LifeState& rhs) const
 {
-	*this &= (~rhs);
+	for (uint64_t rows = rhs.rowsBound(); rows != 0; rows &= rows - 1)
+	{
+		int i = __builtin_ctzll(rows);
+		if ((this->self().word(i) & rhs.word(i)) != 0) return false;
+	}
+	return true;
+}
+
+template <class E>
+LifeState LifeExpr<E>::toLifeState() const
+{
+	return LifeState(this->self());
 }
 
-inline bool LifeState::operator==(const LifeState& rhs) const
+template <class E>
+int LifeExpr<E>::getCell(int x, int y) const { return this->toLifeState().getCell(x, y); }
+template <class E>
+uint64_t LifeExpr<E>::getHash(bool translationInvariant) const { return this->toLifeState().getHash(translationInvariant); }
+template <class E>
+void LifeExpr<E>::getHash128(uint64_t& lo, uint64_t& hi, bool translationInvariant) const { this->toLifeState().getHash128(lo, hi, translationInvariant); }
+template <class E>
+bool LifeExpr<E>::getBoundingBox(int& x, int& y, int& w, int& h) const { return this->toLifeState().getBoundingBox(x, y, w, h); }
+template <class E>
+LifeState LifeExpr<E>::transform(int x, int y) const { return this->toLifeState().transform(x, y); }
+template <class E>
+LifeState LifeExpr<E>::transform(int x, int y, int dxx, int dxy, int dyx, int dyy) const { return this->toLifeState().transform(x, y, dxx, dxy, dyx, dyy); }
+template <class E>
+LifeState LifeExpr<E>::transform(Orientation orientation, int x, int y) const { return this->toLifeState().transform(orientation, x, y); }
+template <class E>
+LifeState LifeExpr<E>::canonical(Orientation* orientation) const { return this->toLifeState().canonical(orientation); }
+template <class E>
+uint64_t LifeExpr<E>::canonicalHash() const { return this->toLifeState().canonicalHash(); }
+template <class E>
+void LifeExpr<E>::run(int gens) const { this->toLifeState().run(gens); }
+template <class E>
+LifeState LifeExpr<E>::after(int gens) const { return this->toLifeState().after(gens); }
+template <class E> template <class Rule>
+LifeState LifeExpr<E>::after(int gens) const { return this->toLifeState().template after<Rule>(gens); }
+template <class E>
+LifeState LifeExpr<E>::after(const IsotropicRule& rule, int gens) const { return this->toLifeState().after(rule, gens); }
+template <class E>
+std::string LifeExpr<E>::toRLE() const { return this->toLifeState().toRLE(); }
+template <class E>
+std::string LifeExpr<E>::toDebugString() const { return this->toLifeState().toDebugString(); }
+template <class E>
+CellList LifeExpr<E>::toCellList() const { return this->toLifeState().toCellList(); }
+template <class E> template <class F>
+F LifeExpr<E>::forEachCell(F f) const { return this->toLifeState().forEachCell(f); }
+template <class E>
+LifeLocator LifeExpr<E>::toLifeLocator() const { return this->toLifeState().toLifeLocator(); }
+template <class E>
+bool LifeExpr<E>::isDisjoint(const LifeState& rhs, int dx, int dy) const { return this->toLifeState().isDisjoint(rhs, dx, dy); }
+template <class E>
+bool LifeExpr<E>::contains(const LifeState& rhs, int dx, int dy) const { return this->toLifeState().contains(rhs, dx, dy); }
+template <class E>
+LifeState LifeExpr<E>::locate(const CellList& target, bool on) const { return this->toLifeState().locate(target, on); }
+template <class E>
+LifeState LifeExpr<E>::locate(const LifeLocator& l) const { return this->toLifeState().locate(l); }
+template <class E>
+LifeState LifeExpr<E>::locate(const LifeLocator& l, int maxMismatches) const { return this->toLifeState().locate(l, maxMismatches); }
+template <class E>
+LifeState LifeExpr<E>::dilate(int x, int y, int w, int h) const { return this->toLifeState().dilate(x, y, w, h); }
+template <class E>
+LifeState LifeExpr<E>::andNot(const LifeState& rhs) const { return this->toLifeState().andNot(rhs); }
+template <class E>
+LifeState LifeExpr<E>::operator*(const CellList& rhs) const { return this->toLifeState() * rhs; }
+template <class E>
+LifeState LifeExpr<E>::operator*(const LifeState& rhs) const { return this->toLifeState() * rhs; }
+
+// Only the rows in the expression's bounds are evaluated, and the exact
+// bounds are found on the way. Each row only reads the same row of its
+// operands, so `a = b & a` is safe in place.
+template <class E>
+void LifeState::assign(const LifeExpr<E>& e)
 {
-    for (int i=0; i < 64; i++)
+	uint64_t candidates = e.self().rowsBound();
+	uint64_t rows = 0;
+	uint64_t cols = 0;
+	for (int i=0; i < 64; i++)
 	{
-        if (this->state[i] != rhs.state[i]) return false;
-    }
-    return true;
+		uint64_t word = ((candidates >> i) & 1) ? e.self().word(i) : 0;
+		this->state[i] = word;
+		rows |= (uint64_t)(word != 0) << i;
+		cols |= word;
+	}
+	this->rows = rows;
+	this->cols = cols;
 }
 
-inline bool LifeState::operator!=(const LifeState& rhs) const
+// A new state from an expression starts from the default settings.
+template <class E>
+LifeState::LifeState(const LifeExpr<E>& e)
 {
-	return !(*this == rhs);
+	this->gen = 0;
+	this->gliderRemoval = GLIDERS_EVERY_GEN;
+	this->gliderPeriod = 1;
+	this->catalog = NULL;
+	this->sink = NULL;
+	this->gliderCount = 0;
+	this->spaceshipCount = 0;
+	this->assign(e);
 }
 
-inline LifeState LifeState::operator~() const
+// An expression only carries cells, so the state keeps its generation,
+// settings and records, as with the compound operators.
+template <class E>
+LifeState& LifeState::operator=(const LifeExpr<E>& e)
 {
-	LifeState result;
+	this->assign(e);
+	return *this;
+}
+
+template <class E>
+void LifeState::operator&=(const LifeExpr<E>& e)
+{
+	this->assign(LifeBinary<LifeOpAnd, LifeState, E>(*this, e.self()));
+}
+
+template <class E>
+void LifeState::operator|=(const LifeExpr<E>& e)
+{
+	this->assign(LifeBinary<LifeOpOr, LifeState, E>(*this, e.self()));
+}
+
+template <class E>
+void LifeState::operator^=(const LifeExpr<E>& e)
+{
+	this->assign(LifeBinary<LifeOpXor, LifeState, E>(*this, e.self()));
+}
+
+template <class E>
+void LifeState::operator-=(const LifeExpr<E>& e)
+{
+	this->assign(LifeBinary<LifeOpAndNot, LifeState, E>(*this, e.self()));
+}
+
+template <class F>
+F LifeState::forEachCell(F f) const
+{
+	for (uint64_t rows = this->rows; rows != 0; rows &= rows - 1)
+	{
+		int i = __builtin_ctzll(rows);
+		for (uint64_t word = this->state[i]; word != 0; word &= word - 1)
+		{
+			f(i - 32, __builtin_ctzll(word) - 32);
+		}
+	}
+	return f;
+}
+
+inline void LifeState::andInto(LifeState& dst, const LifeState& a, const LifeState& b)
+{
+	uint64_t rows = 0;
+	uint64_t cols = 0;
 	for (int i=0; i < 64; i++)
 	{
-		result.state[i] = ~(this->state[i]);
+		uint64_t word = a.state[i] & b.state[i];
+		dst.state[i] = word;
+		rows |= (uint64_t)(word != 0) << i;
+		cols |= word;
 	}
-	result.recalculateMinMax();
-	return result;
+	dst.rows = rows;
+	dst.cols = cols;
+}
+
+inline void LifeState::andNotInto(LifeState& dst, const LifeState& a, const LifeState& b)
+{
+	uint64_t rows = 0;
+	uint64_t cols = 0;
+	for (int i=0; i < 64; i++)
+	{
+		uint64_t word = a.state[i] & ~b.state[i];
+		dst.state[i] = word;
+		rows |= (uint64_t)(word != 0) << i;
+		cols |= word;
+	}
+	dst.rows = rows;
+	dst.cols = cols;
+}
+
+inline void LifeState::orInto(LifeState& dst, const LifeState& a, const LifeState& b)
+{
+	for (int i=0; i < 64; i++)
+	{
+		dst.state[i] = a.state[i] | b.state[i];
+	}
+	dst.rows = a.rows | b.rows;
+	dst.cols = a.cols | b.cols;
+}
+
+inline void LifeState::xorInto(LifeState& dst, const LifeState& a, const LifeState& b)
+{
+	for (int i=0; i < 64; i++)
+	{
+		dst.state[i] = a.state[i] ^ b.state[i];
+	}
+	dst.rows = a.rows | b.rows;
+	dst.cols = a.cols | b.cols;
+}
+
+inline void LifeState::operator&=(const LifeState& rhs)
+{
+	andInto(*this, *this, rhs);
+}
+
+inline void LifeState::operator^=(const LifeState& rhs)
+{
+	xorInto(*this, *this, rhs);
+}
+
+inline void LifeState::operator|=(const LifeState& rhs)
+{
+	orInto(*this, *this, rhs);
 }
 
-inline LifeState LifeState::operator&(const LifeState& rhs) const
+inline void LifeState::operator+=(const LifeState& rhs)
+{
+	*this |= rhs;
+}
+
+inline void LifeState::operator-=(const LifeState& rhs)
+{
+	andNotInto(*this, *this, rhs);
+}
+
+inline LifeState LifeState::andNot(const LifeState& rhs) const
 {
 	LifeState result;
-    for (int i=0; i < 64; i++)
+	andNotInto(result, *this, rhs);
+	return result;
+}
+
+// Iteration under other rules
+
+template <class Rule>
+void LifeState::iterate()
+{
+	// With B0 the empty rows outside the bounds come alive too.
+	this->iterate(&LifeState::iterateRows<Rule>, (Rule::BIRTH & 1) != 0);
+}
+
+template <class Rule>
+void LifeState::iterateRows(uint64_t* state, int start, int last, bool wrap)
+{
+	uint64_t bit0[64];
+	uint64_t bit1[64];
+	for (int i = start; i <= last; i++)
 	{
-        result.state[i] = this->state[i] & rhs.state[i];
-    }
-    result.recalculateMinMax();
+		uint64_t m = state[i];
+		uint64_t l = (m << 1) | (m >> 63);
+		uint64_t r = (m >> 1) | (m << 63);
+		bit0[i] = l ^ r ^ m;
+		bit1[i] = ((l | r) & m) | (l & r);
+	}
+
+	uint64_t first = 0, final = 0;
+	if (wrap)
+	{
+		first = Rule::evolve(state[0], bit0[64 - 1], bit1[64 - 1], bit0[1], bit1[1]);
+		final = Rule::evolve(state[64 - 1], bit0[64 - 2], bit1[64 - 2], bit0[0], bit1[0]);
+	}
+	for (int i = start + 1; i <= last - 1; i++)
+	{
+		state[i] = Rule::evolve(state[i], bit0[i - 1], bit1[i - 1], bit0[i + 1], bit1[i + 1]);
+	}
+	if (wrap)
+	{
+		state[0] = first;
+		state[64 - 1] = final;
+	}
+}
+
+template <class Rule>
+void LifeState::run(int gens)
+{
+	for (int i = 0; i < gens; i++)
+	{
+		this->iterate<Rule>();
+	}
+}
+
+// Conway's Life keeps the SIMD kernels and glider removal.
+template <>
+inline void LifeState::run<ConwayLife>(int gens)
+{
+	this->run(gens);
+}
+
+template <class Rule>
+LifeState LifeState::after(int gens) const
+{
+	LifeState result(*this);
+	result.run<Rule>(gens);
 	return result;
 }
 
-inline LifeState LifeState::operator|(const LifeState& rhs) const
+// Width-templated states
+
+// Row words for BasicLifeState<N>. 32, 64 and 128 use builtin integers
+// (128 needs __int128 support); 256 is a four-word struct that compilers
+// keep in AVX registers when it's enabled.
+template <int N> struct LifeRow;
+
+template <> struct LifeRow<32>
 {
-	LifeState result;
-    for (int i=0; i < 64; i++)
+	typedef uint32_t Word;
+	static Word zero() { return 0; }
+	static Word bit(int k) { return Word(1) << k; }
+	static bool isZero(Word w) { return w == 0; }
+	static int popcount(Word w) { return __builtin_popcountll(w); }
+};
+
+template <> struct LifeRow<64>
+{
+	typedef uint64_t Word;
+	static Word zero() { return 0; }
+	static Word bit(int k) { return Word(1) << k; }
+	static bool isZero(Word w) { return w == 0; }
+	static int popcount(Word w) { return __builtin_popcountll(w); }
+};
+
+#ifdef __SIZEOF_INT128__
+template <> struct LifeRow<128>
+{
+	typedef unsigned __int128 Word;
+	static Word zero() { return 0; }
+	static Word bit(int k) { return Word(1) << k; }
+	static bool isZero(Word w) { return w == 0; }
+	static int popcount(Word w) { return __builtin_popcountll((uint64_t)w) + __builtin_popcountll((uint64_t)(w >> 64)); }
+};
+#endif
+
+struct LifeWord256
+{
+	uint64_t w[4]; // w[0] holds the lowest bits
+};
+
+inline LifeWord256 operator&(const LifeWord256& a, const LifeWord256& b)
+{
+	LifeWord256 r = {{a.w[0] & b.w[0], a.w[1] & b.w[1], a.w[2] & b.w[2], a.w[3] & b.w[3]}};
+	return r;
+}
+
+inline LifeWord256 operator|(const LifeWord256& a, const LifeWord256& b)
+{
+	LifeWord256 r = {{a.w[0] | b.w[0], a.w[1] | b.w[1], a.w[2] | b.w[2], a.w[3] | b.w[3]}};
+	return r;
+}
+
+inline LifeWord256 operator^(const LifeWord256& a, const LifeWord256& b)
+{
+	LifeWord256 r = {{a.w[0] ^ b.w[0], a.w[1] ^ b.w[1], a.w[2] ^ b.w[2], a.w[3] ^ b.w[3]}};
+	return r;
+}
+
+inline LifeWord256 operator~(const LifeWord256& a)
+{
+	LifeWord256 r = {{~a.w[0], ~a.w[1], ~a.w[2], ~a.w[3]}};
+	return r;
+}
+
+inline LifeWord256 operator<<(const LifeWord256& a, int k)
+{
+	LifeWord256 r;
+	int words = k / 64;
+	int bits = k % 64;
+	for (int i = 0; i < 4; i++)
+	{
+		int src = i - words;
+		uint64_t hi = (src >= 0) ? a.w[src] : 0;
+		uint64_t lo = (src >= 1) ? a.w[src - 1] : 0;
+		r.w[i] = bits ? ((hi << bits) | (lo >> (64 - bits))) : hi;
+	}
+	return r;
+}
+
+inline LifeWord256 operator>>(const LifeWord256& a, int k)
+{
+	LifeWord256 r;
+	int words = k / 64;
+	int bits = k % 64;
+	for (int i = 0; i < 4; i++)
+	{
+		int src = i + words;
+		uint64_t lo = (src < 4) ? a.w[src] : 0;
+		uint64_t hi = (src + 1 < 4) ? a.w[src + 1] : 0;
+		r.w[i] = bits ? ((lo >> bits) | (hi << (64 - bits))) : lo;
+	}
+	return r;
+}
+
+inline bool operator==(const LifeWord256& a, const LifeWord256& b)
+{
+	return a.w[0] == b.w[0] && a.w[1] == b.w[1] && a.w[2] == b.w[2] && a.w[3] == b.w[3];
+}
+
+inline bool operator!=(const LifeWord256& a, const LifeWord256& b)
+{
+	return !(a == b);
+}
+
+template <> struct LifeRow<256>
+{
+	typedef LifeWord256 Word;
+	static Word zero() { Word r = {{0, 0, 0, 0}}; return r; }
+	static Word bit(int k) { Word r = zero(); r.w[k / 64] = 1ULL << (k % 64); return r; }
+	static bool isZero(const Word& w) { return (w.w[0] | w.w[1] | w.w[2] | w.w[3]) == 0; }
+	static int popcount(const Word& w)
+	{
+		return __builtin_popcountll(w.w[0]) + __builtin_popcountll(w.w[1])
+			+ __builtin_popcountll(w.w[2]) + __builtin_popcountll(w.w[3]);
+	}
+};
+
+// An N x N torus with N-bit rows, for N = 32, 64, 128 or 256. Uses the
+// same conventions as LifeState: (0, 0) is in the centre and each word
+// is a column. Small searches fit in BasicLifeState<32> and big reactions
+// fit in 128 or 256 without tiling.
+// This is the evolution core only: there's no bounds tracking, glider
+// removal or pattern matching, so convert to a LifeState for those.
+// The step is scalar code on whole words, without LifeState's SIMD
+// kernels, so LifeState is the faster choice for a 64x64 torus.
+template <int N>
+class BasicLifeState
+{
+public:
+	typedef typename LifeRow<N>::Word Word;
+	BasicLifeState() { this->clear(); }
+	BasicLifeState(const char* rle, int x=0, int y=0);
+	static BasicLifeState fromLifeState(const LifeState& s);
+	void clear();
+	void setCell(int x, int y, int val);
+	int getCell(int x, int y) const;
+	int getPop() const;
+	int getGen() const { return this->gen; }
+	bool operator==(const BasicLifeState& rhs) const;
+	bool operator!=(const BasicLifeState& rhs) const { return !(*this == rhs); }
+	void operator|=(const BasicLifeState& rhs);
+	void move(int x, int y);
+	void run(int gens=1);
+	BasicLifeState after(int gens) const { BasicLifeState result(*this); result.run(gens); return result; }
+	std::string toRLE() const;
+	// The 64x64 centre (or the whole state, padded with dead cells).
+	LifeState toLifeState() const;
+private:
+	int gen;
+	Word state[N];
+	static Word rotateLeft(const Word& w, int k) { k %= N; return k ? ((w << k) | (w >> (N - k))) : w; }
+	static Word rotateRight(const Word& w, int k) { return rotateLeft(w, N - k % N); }
+	void iterate();
+};
+
+typedef BasicLifeState<32> LifeState32;
+typedef BasicLifeState<64> LifeState64;
+#ifdef __SIZEOF_INT128__
+typedef BasicLifeState<128> LifeState128;
+#endif
+typedef BasicLifeState<256> LifeState256;
+
+template <int N>
+BasicLifeState<N>::BasicLifeState(const char* rle, int x, int y)
+{
+	this->clear();
+	CellList cells(rle, x, y);
+	for (CellList::const_iterator it = cells.begin(); it != cells.end(); ++it)
+	{
+		this->setCell(it->x, it->y, 1);
+	}
+}
+
+template <int N>
+BasicLifeState<N> BasicLifeState<N>::fromLifeState(const LifeState& s)
+{
+	BasicLifeState result;
+	int half = (N < 64 ? N : 64) / 2;
+	for (int x = -half; x < half; x++)
 	{
-        result.state[i] = this->state[i] | rhs.state[i];
-    }
-    result.recalculateMinMax();
+		for (int y = -half; y < half; y++)
+		{
+			if (s.getCell(x, y))
+			{
+				result.setCell(x, y, 1);
+			}
+		}
+	}
+	result.gen = s.getGen();
 	return result;
 }
 
-inline LifeState LifeState::operator^(const LifeState& rhs) const
+template <int N>
+LifeState BasicLifeState<N>::toLifeState() const
 {
 	LifeState result;
-    for (int i=0; i < 64; i++)
+	int half = (N < 64 ? N : 64) / 2;
+	for (int x = -half; x < half; x++)
 	{
-        result.state[i] = this->state[i] ^ rhs.state[i];
-    }
-    result.recalculateMinMax();
+		for (int y = -half; y < half; y++)
+		{
+			if (this->getCell(x, y))
+			{
+				result.setCell(x, y, 1);
+			}
+		}
+	}
 	return result;
 }
 
-inline LifeState LifeState::operator+(const LifeState& rhs) const
+template <int N>
+void BasicLifeState<N>::clear()
+{
+	for (int i = 0; i < N; i++)
+	{
+		this->state[i] = LifeRow<N>::zero();
+	}
+	this->gen = 0;
+}
+
+template <int N>
+void BasicLifeState<N>::setCell(int x, int y, int val)
 {
-	return (*this) | rhs;
+	int i = ((x + N / 2) % N + N) % N;
+	int j = ((y + N / 2) % N + N) % N;
+	if (val)
+	{
+		this->state[i] = this->state[i] | LifeRow<N>::bit(j);
+	}
+	else
+	{
+		this->state[i] = this->state[i] & ~LifeRow<N>::bit(j);
+	}
 }
 
-inline LifeState LifeState::operator-(const LifeState& rhs) const
+template <int N>
+int BasicLifeState<N>::getCell(int x, int y) const
 {
-	return (*this) & (~rhs);
+	int i = ((x + N / 2) % N + N) % N;
+	int j = ((y + N / 2) % N + N) % N;
+	return LifeRow<N>::isZero(this->state[i] & LifeRow<N>::bit(j)) ? 0 : 1;
+}
+
+template <int N>
+int BasicLifeState<N>::getPop() const
+{
+	int pop = 0;
+	for (int i = 0; i < N; i++)
+	{
+		pop += LifeRow<N>::popcount(this->state[i]);
+	}
+	return pop;
+}
+
+template <int N>
+bool BasicLifeState<N>::operator==(const BasicLifeState& rhs) const
+{
+	for (int i = 0; i < N; i++)
+	{
+		if (this->state[i] != rhs.state[i]) return false;
+	}
+	return true;
+}
+
+template <int N>
+void BasicLifeState<N>::operator|=(const BasicLifeState& rhs)
+{
+	for (int i = 0; i < N; i++)
+	{
+		this->state[i] = this->state[i] | rhs.state[i];
+	}
+}
+
+template <int N>
+void BasicLifeState<N>::move(int x, int y)
+{
+	Word temp[N];
+	int dx = (x % N + N) % N;
+	for (int i = 0; i < N; i++)
+	{
+		temp[(i + dx) % N] = rotateLeft(this->state[i], (y % N + N) % N);
+	}
+	for (int i = 0; i < N; i++)
+	{
+		this->state[i] = temp[i];
+	}
+}
+
+// The same half-adder/full-adder pipeline as evolve() in LifeAPI.cpp.
+template <int N>
+void BasicLifeState<N>::iterate()
+{
+	Word bit0[N], bit1[N];
+	for (int i = 0; i < N; i++)
+	{
+		Word m = this->state[i];
+		Word l = rotateLeft(m, 1);
+		Word r = rotateRight(m, 1);
+		bit0[i] = l ^ r ^ m;
+		bit1[i] = ((l | r) & m) | (l & r);
+	}
+
+	// Rows only read their own old value and the bit counts, so they can
+	// be written back in place.
+	for (int i = 0; i < N; i++)
+	{
+		int up = (i + N - 1) % N;
+		int down = (i + 1) % N;
+		Word temp = this->state[i];
+		Word sum0, sum1, sum2, t;
+		sum0 = rotateLeft(temp, 1);
+		Word r = rotateRight(temp, 1);
+		sum1 = sum0 & r;
+		sum0 = sum0 ^ r;
+		sum1 = sum1 | (sum0 & bit0[up]);
+		sum0 = sum0 ^ bit0[up];
+		sum2 = sum1 & bit1[up];
+		sum1 = sum1 ^ bit1[up];
+		t = sum0 & bit0[down];
+		sum2 = sum2 | (t & sum1);
+		sum1 = sum1 ^ t;
+		sum0 = sum0 ^ bit0[down];
+		sum2 = sum2 | (sum1 & bit1[down]);
+		sum1 = sum1 ^ bit1[down];
+		this->state[i] = ~sum2 & sum1 & (temp | sum0);
+	}
+	this->gen++;
+}
+
+template <int N>
+void BasicLifeState<N>::run(int gens)
+{
+	for (int i = 0; i < gens; i++)
+	{
+		this->iterate();
+	}
+}
+
+template <int N>
+std::string BasicLifeState<N>::toRLE() const
+{
+	RLEWriter writer;
+	for (int j = 0; j < N; j++)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			writer.cell(LifeRow<N>::isZero(this->state[i] & LifeRow<N>::bit(j)) ? 0 : 1);
+		}
+		writer.endRow();
+	}
+	return writer.finish();
 }
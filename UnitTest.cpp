@@ -1,4 +1,6 @@
 #include "LifeAPI.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 void testWithMsg(bool (*test_fn)(), const char* test_msg)
@@ -150,9 +152,533 @@ bool testTransform02()
     return (ta == tb);
 }
 
+bool testTransform03()
+{
+    // Each orientation against a cell-by-cell copy.
+    static const int matrices[8][4] = {
+        {1, 0, 0, 1}, {0, -1, 1, 0}, {-1, 0, 0, -1}, {0, 1, -1, 0},
+        {-1, 0, 0, 1}, {1, 0, 0, -1}, {0, 1, 1, 0}, {0, -1, -1, 0}
+    };
+    LifeState soup = LifeState::makeRandomState();
+    bool status = true;
+    for (int o=0; o<8; ++o)
+    {
+        const int* m = matrices[o];
+        LifeState expected;
+        for (int x=-32; x<32; ++x)
+        {
+            for (int y=-32; y<32; ++y)
+            {
+                int x1 = x * m[0] + y * m[1] + 3;
+                int y1 = x * m[2] + y * m[3] - 5;
+                expected.setCell((x1 + 64) % 64, (y1 + 64) % 64, soup.getCell(x, y));
+            }
+        }
+        status = status && (soup.transform((Orientation)o, 3, -5) == expected);
+    }
+    // A rotated glider still runs under the non-wrapping iterate.
+    LifeState a = LifeState("bo$2bo$3o!").transform(ORIENT_ROT90);
+    status = status && (a.after(4) == a.transform(-1, 1));
+    return status;
+}
+
+bool testMove01()
+{
+    // Moving commutes with running, including moves across the torus edge.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-8, -8, 16, 16);
+    int moves[][2] = {{0, 0}, {5, -3}, {-40, 27}, {64, -64}, {30, 30}, {-100, 77}};
+    bool status = true;
+    for (size_t i=0; i<sizeof(moves) / sizeof(moves[0]); ++i)
+    {
+        LifeState moved = soup.transform(moves[i][0], moves[i][1]);
+        status = status && (moved.after(20) == soup.after(20).transform(moves[i][0], moves[i][1]));
+        moved.move(-moves[i][0], -moves[i][1]);
+        status = status && (moved == soup);
+    }
+    return status;
+}
+
+bool testOperators01()
+{
+    // The output forms agree with the operators, also when writing over an input.
+    LifeState a = LifeState::makeRandomState() & LifeState::makeRect(-20, -10, 30, 40);
+    LifeState b = LifeState::makeRandomState();
+    LifeState expected[4] = {a & b, a | b, a ^ b, a & ~b};
+    bool status = (a - b == expected[3]) && (a.andNot(b) == expected[3]);
+    for (int op=0; op<4; ++op)
+    {
+        LifeState dst;
+        LifeState inPlace = a;
+        switch (op)
+        {
+        case 0: LifeState::andInto(dst, a, b); LifeState::andInto(inPlace, inPlace, b); break;
+        case 1: LifeState::orInto(dst, a, b); LifeState::orInto(inPlace, inPlace, b); break;
+        case 2: LifeState::xorInto(dst, a, b); LifeState::xorInto(inPlace, inPlace, b); break;
+        default: LifeState::andNotInto(dst, a, b); LifeState::andNotInto(inPlace, inPlace, b); break;
+        }
+        status = status && (dst == expected[op]) && (inPlace == expected[op]);
+        // Merged bounds still cover every live cell, so evolution is unchanged.
+        status = status && (dst.after(10) == LifeState(expected[op].toRLE().c_str(), -32, -32).after(10));
+    }
+    return status;
+}
+
+#if __cplusplus >= 201103L
+const LifeState constRect(int x, int y, int w, int h)
+{
+    return LifeState::makeRect(x, y, w, h);
+}
+#endif
+
+bool testOperators02()
+{
+    // Fused expressions agree with step by step evaluation.
+    LifeState a = LifeState::makeRandomState();
+    LifeState b = LifeState::makeRandomState() & LifeState::makeRect(-10, -10, 20, 20);
+    LifeState c = LifeState::makeRandomState() & LifeState::makeRect(5, -30, 10, 10);
+    LifeState notB;
+    LifeState::xorInto(notB, b, ~LifeState());
+    LifeState expected;
+    LifeState::andInto(expected, a, notB);
+    LifeState::orInto(expected, expected, c);
+    LifeState fused = (a & ~b) | c;
+    bool status = (fused == expected) && ((a & ~b) | c) == expected && (fused.getPop() == ((a & ~b) | c).getPop());
+    status = status && ((b - c) == (b & ~c)) && ((a ^ b) == ((a | b) - (a & b)));
+    // Reductions on an expression.
+    status = status && (b & c).isEmpty() && !(a & b).isEmpty();
+    status = status && (~a).isDisjoint(a) && (a | c).contains(c) && !(a - c).contains(c);
+    // Assigning over an operand, and compound forms.
+    LifeState d = a;
+    d = b & d;
+    LifeState e = a;
+    e &= b | c;
+    status = status && (d == (a & b)) && (e == (a & (b | c)));
+#if __cplusplus >= 201103L
+    // Temporaries are held by value, so a saved expression stays valid.
+    auto held = b & LifeState::makeRect(-10, -10, 20, 20);
+    auto both = ~LifeState::makeRect(0, 0, 4, 4) - LifeState::makeRect(-32, -32, 64, 32);
+    auto constant = b & constRect(-10, -10, 20, 20);
+    status = status && (held == b) && (LifeState(both).getPop() == 64 * 32 - 16) && (constant == b);
+#endif
+    // An expression has the const API of a LifeState.
+    LifeState ab = a & b;
+    status = status && ((a & b).toRLE() == ab.toRLE()) && ((a ^ b).transform(3, -5) == (a ^ b).toLifeState().transform(3, -5));
+    status = status && ((a & b).getPop() == ab.getPop()) && ((a | c).after(3) == LifeState(a | c).after(3));
+    status = status && ((a & b).getHash() == ab.getHash()) && ((a & b).getCell(0, 0) == ab.getCell(0, 0));
+    (a | b).run();
+    // A new state from an expression starts from the default settings, and
+    // assigning one keeps the state's own.
+    LifeState g("bo$2bo$3o!");
+    g.setGliderRemoval(GLIDERS_OFF);
+    g.run(4);
+    LifeState h = g | LifeState();
+    g = g | LifeState();
+    status = status && (h.getGen() == 0) && (h.getGliderRemoval() == GLIDERS_EVERY_GEN);
+    status = status && (g.getGen() == 4) && (g.getGliderRemoval() == GLIDERS_OFF) && (g == h);
+    return status;
+}
+
+bool testCanonical01()
+{
+    // Every orientation and translation has the same canonical form.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-6, -4, 12, 9);
+    LifeState canon = soup.canonical();
+    int x, y, w, h;
+    bool status = canon.getBoundingBox(x, y, w, h) && (x == -32) && (y == -32);
+    for (int o=0; o<8; ++o)
+    {
+        LifeState image = soup.transform((Orientation)o, 7 * o - 20, 29 - 11 * o);
+        status = status && (image.canonical() == canon) && (image.canonicalHash() == soup.canonicalHash());
+    }
+    // The reported orientation reproduces it.
+    Orientation orientation;
+    canon = soup.canonical(&orientation);
+    LifeState picked = soup.transform(orientation);
+    status = status && picked.getBoundingBox(x, y, w, h) && (picked.transform(-32 - x, -32 - y) == canon);
+    // Sparse patterns with a gap on the seam or two equal gaps.
+    const char* sparse[] = {"o4bo$obo2bo$2o3bo!", "obo$2bo31$o!", "o15bo15bo$bo!"};
+    for (size_t i=0; i<sizeof(sparse) / sizeof(sparse[0]); ++i)
+    {
+        LifeState pattern(sparse[i]);
+        LifeState form = pattern.canonical();
+        for (int x=0; x<64; x+=3)
+        {
+            for (int y=0; y<64; y+=7)
+            {
+                LifeState image = pattern.transform((Orientation)((x + y) % 8), x, y);
+                status = status && (image.canonical(&orientation) == form);
+                status = status && (image.transform(orientation).getHash(true) == form.getHash(true));
+            }
+        }
+    }
+    // A different pattern stays different.
+    LifeState other = soup;
+    other.setCell(0, 0, 1 - soup.getCell(0, 0));
+    return status && (other.canonicalHash() != soup.canonicalHash());
+}
+
+bool testConvolve01()
+{
+    // Convolution against ORing one shifted copy per kernel cell.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRandomState() & LifeState::makeRandomState();
+    LifeState kernels[] = {
+        LifeState::makeRect(-1, -1, 3, 3),
+        LifeState::makeRect(-2, 30, 5, 4),
+        LifeState::makeRandomState() & LifeState::makeRect(-3, -3, 7, 7),
+        LifeState("2o$bo$o2bo!", 20, -20),
+        LifeState()
+    };
+    bool status = true;
+    for (size_t i=0; i<sizeof(kernels) / sizeof(kernels[0]); ++i)
+    {
+        LifeState expected;
+        CellList cells = kernels[i].toCellList();
+        for (size_t n=0; n<cells.size(); ++n)
+        {
+            expected |= soup.transform(cells[n].x, cells[n].y);
+        }
+        status = status && (soup * kernels[i] == expected) && (soup * cells == expected);
+    }
+    status = status && (soup.dilate(3, -2, 4, 7) == soup * LifeState::makeRect(3, -2, 7, 4));
+    // Kernels wider than the torus cover it.
+    status = status && (soup.dilate(0, 0, 100, 1) == soup.dilate(0, 0, 64, 1));
+    return status;
+}
+
+bool testBounds01()
+{
+    // Patterns across the torus seam evolve like centred copies.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-6, -6, 12, 12);
+    int moves[][2] = {{32, 0}, {0, 32}, {32, 32}, {29, -35}};
+    bool status = true;
+    for (size_t i=0; i<sizeof(moves) / sizeof(moves[0]); ++i)
+    {
+        LifeState moved = soup.transform(moves[i][0], moves[i][1]);
+        status = status && (moved.after(30) == soup.after(30).transform(moves[i][0], moves[i][1]));
+        status = status && (moved.after<HighLife>(30) == soup.after<HighLife>(30).transform(moves[i][0], moves[i][1]));
+    }
+    // The bounding box wraps as well.
+    int x = 0, y = 0, w = 0, h = 0;
+    LifeState line("3o!", 30, -1);
+    status = status && line.getBoundingBox(x, y, w, h) && x == 30 && y == -1 && w == 3 && h == 1;
+    line.setCell(30, -1, 0);
+    status = status && line.getBoundingBox(x, y, w, h) && x == 31 && w == 2;
+    // The seam can fall in a gap inside the pattern.
+    for (int d=-32; d<32; d+=7)
+    {
+        LifeState row("o4bo$obo2bo$2o3bo!", 27, d);
+        status = status && row.getBoundingBox(x, y, w, h) && x == 27 && w == 6 && h == 3;
+        LifeState column("o$o$o3$o!", d, 27);
+        status = status && column.getBoundingBox(x, y, w, h) && y == 27 && h == 6 && w == 1;
+    }
+    status = status && !LifeState().getBoundingBox(x, y, w, h);
+    // Cells set after a run are still counted.
+    LifeState a("bo$2bo$3o!");
+    a.run(4);
+    a.setCell(-20, -20, 1);
+    status = status && (a.getPop() == 6) && (a.after(1).getPop() == 5);
+    return status;
+}
+
+bool testSimdKernels01()
+{
+    // Every supported kernel should agree with the portable one.
+    SimdLevel best = LifeState::getSimdLevel();
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-9, -13, 21, 17);
+    LifeState torus = LifeState::makeRandomState();
+    LifeState::setSimdLevel(SIMD_NONE);
+    LifeState soup_expected = soup.after(100);
+    LifeState torus_expected = torus.after(100);
+    bool status = true;
+    SimdLevel levels[] = {SIMD_SSE2, SIMD_AVX2, SIMD_AVX512};
+    for (size_t i=0; i<3; ++i)
+    {
+        if (!LifeState::setSimdLevel(levels[i]))
+        {
+            continue;
+        }
+        status = status && (soup.after(100) == soup_expected);
+        status = status && (torus.after(100) == torus_expected);
+    }
+    LifeState::setSimdLevel(best);
+    return status;
+}
+
+bool testFusedRun01()
+{
+    // Fused blocks of generations match one generation at a time, and a
+    // glider still gets removed when it reaches the edge.
+    SimdLevel best = LifeState::getSimdLevel();
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-8, -8, 16, 16);
+    typedef LifeRule<0x8 | 0x200, 0xC> SlowLife;
+    bool status = true;
+    SimdLevel levels[] = {SIMD_NONE, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512};
+    int gens[] = {1, 2, 3, 7, 25, 60};
+    for (size_t i=0; i<4; ++i)
+    {
+        if (!LifeState::setSimdLevel(levels[i]))
+        {
+            continue;
+        }
+        for (size_t j=0; j<6; ++j)
+        {
+            status = status && (soup.after(gens[j]) == soup.after<SlowLife>(gens[j]));
+            status = status && (soup.after(gens[j]).getGen() == gens[j]);
+        }
+        LifeState g("bo$2bo$3o!");
+        g.run(200);
+        status = status && (g.getPop() == 0) && (g.getGliderCount() == 1);
+    }
+    LifeState::setSimdLevel(best);
+    return status;
+}
+
 // Copied from LifeState::removeGliders...
 static const LifeState glider("bo$2bo$3o!", -2, -2);
 
+struct CellCounter
+{
+    int count;
+    int sum;
+    void operator()(int x, int y) { count++; sum += x * 64 + y; }
+};
+
+bool testCellList01()
+{
+    // Scanning visits every live cell once, across the torus edge too.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRandomState();
+    LifeState sparse("o$3bo!", 30, -33);
+    bool status = true;
+    LifeState states[] = {soup, sparse, LifeState()};
+    for (int i=0; i<3; ++i)
+    {
+        CellCounter counter = {0, 0};
+        counter = states[i].forEachCell(counter);
+        int sum = 0;
+        CellList lines;
+        for (int y=-32; y<32; ++y)
+        {
+            for (int x=-32; x<32; ++x)
+            {
+                sum += states[i].getCell(x, y) * (x * 64 + y);
+                if (states[i].getCell(x, y))
+                {
+                    Cell c = {x, y};
+                    lines.push_back(c);
+                }
+            }
+        }
+        CellList cells = states[i].toCellList();
+        status = status && (counter.count == states[i].getPop()) && (counter.sum == sum);
+        status = status && ((int)cells.size() == states[i].getPop()) && (cells.toLifeState() == states[i]);
+        // toCellList() keeps the line by line order.
+        for (size_t n=0; n<cells.size() && n<lines.size(); ++n)
+        {
+            status = status && (cells[n].x == lines[n].x) && (cells[n].y == lines[n].y);
+        }
+    }
+    return status;
+}
+
+bool testStability01()
+{
+    // A tromino settles into a block, a blinker oscillates, a glider moves.
+    LifeState tromino("2o$o!");
+    StabilityData data = tromino.runUntilStable(100);
+    bool status = data.stable && (data.gen == 1) && (data.period == 1) && (data.dx == 0) && (data.dy == 0);
+    status = status && (tromino.getGen() == 2) && (tromino == LifeState("2o$2o!"));
+    LifeState blinker("3o!");
+    data = blinker.runUntilStable(100);
+    status = status && data.stable && (data.gen == 0) && (data.period == 2) && (data.dx == 0);
+    LifeState glider("bo$2bo$3o!");
+    data = glider.runUntilStable(100);
+    status = status && data.stable && (data.gen == 0) && (data.period == 4) && (data.dx == 1) && (data.dy == 1);
+    // Also across the seam, where the gap between two gliders wraps.
+    for (int x=20; x<32; ++x)
+    {
+        LifeState pair = glider.transform(x, 0) | glider.transform(x + 6, 0);
+        pair.setGliderRemoval(GLIDERS_OFF);
+        data = pair.runUntilStable(100);
+        status = status && data.stable && (data.gen == 0) && (data.period == 4) && (data.dx == 1) && (data.dy == 1);
+    }
+    // A period too long to see is not reported.
+    LifeState slow("3o!");
+    data = slow.runUntilStable(50, 1);
+    status = status && !data.stable && (slow.getGen() == 50);
+    // A soup's report holds up, with the cycle starting no later.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-4, -4, 8, 8);
+    LifeState start = soup;
+    data = soup.runUntilStable(2000, 30);
+    if (data.stable)
+    {
+        LifeState first = (data.gen == 0) ? start : start.after(data.gen);
+        status = status && (first.transform(data.dx, data.dy) == soup) && (soup.getGen() == data.gen + data.period);
+        if (data.gen > 0)
+        {
+            LifeState before = (data.gen == 1) ? start : start.after(data.gen - 1);
+            status = status && !(before.transform(data.dx, data.dy) == start.after(data.gen - 1 + data.period));
+        }
+    }
+    return status;
+}
+
+bool testCollision01()
+{
+    // Starting at the first contact gives what running from the start does.
+    LifeState block("2o$2o!");
+    LifeState glider("bo$2bo$3o!");
+    int contacts = 0;
+    bool status = true;
+    for (int x=-12; x<12; x+=3)
+    {
+        for (int y=-12; y<12; ++y)
+        {
+            LifeCollision collision;
+            status = status && collision.add(block) && collision.add(glider.transform(x, y));
+            LifeState state = block;
+            state |= glider.transform(x, y);
+            if (!glider.transform(x, y).isDisjoint(block.dilate(-3, -3, 8, 8)))
+            {
+                continue;
+            }
+            int gen = collision.getContactGen(120);
+            LifeState merged = collision.at(std::max(gen, 0));
+            status = status && (gen != 0) && (merged.getGen() == std::max(gen, 0));
+            merged.run(120 - merged.getGen());
+            state.run(120);
+            status = status && (merged == state);
+            contacts += (gen > 0);
+        }
+    }
+    // A glider flying away never meets the block.
+    LifeCollision collision;
+    collision.add(block);
+    collision.add(glider.transform(4, 4), 4, 1, 1);
+    status = status && (collision.getContactGen(200) == -1) && (collision.at(200) == block);
+    // Only patterns that repeat can be pieces.
+    status = status && !collision.add(LifeState("3o$o!"), 8) && (collision.size() == 2);
+    return status && (contacts > 0);
+}
+
+// Compares at(g) with running the pieces together, up to the contact.
+bool followsRun(const LifeCollision& collision, LifeState state, int maxGens)
+{
+    int contact = collision.getContactGen(maxGens);
+    int last = (contact < 0) ? maxGens : contact;
+    bool status = true;
+    for (int gen=0; gen<=last; ++gen)
+    {
+        status = status && (collision.at(gen) == state);
+        state.run(1);
+    }
+    return status;
+}
+
+bool testCollision02()
+{
+    // A ship wraps around the torus into a block behind it.
+    LifeState lwss("bo2bo$o$o3bo$4o!");
+    LifeState block("2o$2o!", 12, 1);
+    LifeCollision collision;
+    bool status = collision.add(lwss) && collision.add(block);
+    int contact = collision.getContactGen(400);
+    status = status && (contact > 0) && (contact < 120) && followsRun(collision, lwss | block, 400);
+    // Gliders are removed at the edge when run() would, and a block
+    // straddling the seam is there from the start.
+    LifeState glider("bo$2bo$3o!");
+    LifeState seamBlock("2o$2o!", 31, 31);
+    for (int y=-30; y<30; y+=4)
+    {
+        LifeCollision pair;
+        pair.add(glider.transform(0, y));
+        pair.add(seamBlock);
+        status = status && followsRun(pair, glider.transform(0, y) | seamBlock, 200);
+    }
+    return status;
+}
+
+bool testHash01()
+{
+    // Shifted copies hash apart unless the hash is translation-invariant.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-5, -5, 10, 10);
+    LifeState shifted = soup.transform(3, 1);
+    LifeState wrapped = soup.transform(30, -29);
+    bool status = (soup.getHash() != shifted.getHash()) && (soup.getHash() != wrapped.getHash());
+    status = status && (soup.getHash(true) == shifted.getHash(true)) && (soup.getHash(true) == wrapped.getHash(true));
+    // Also when a gap inside the pattern lands on the seam, and when two
+    // gaps are equally long.
+    LifeState gappy("o4bo$obo2bo$2o3bo!");
+    LifeState tie;
+    tie.setCell(0, 0, 1);
+    tie.setCell(2, 0, 1);
+    tie.setCell(2, 1, 1);
+    tie.setCell(-31, 0, 1);
+    for (int x=0; x<64; ++x)
+    {
+        for (int y=0; y<64; y+=5)
+        {
+            status = status && (gappy.transform(x, y).getHash(true) == gappy.getHash(true));
+            status = status && (tie.transform(x, y).getHash(true) == tie.getHash(true));
+        }
+    }
+    // Every single cell hashes differently.
+    std::vector<uint64_t> hashes;
+    for (int x=-32; x<32; ++x)
+    {
+        for (int y=-32; y<32; ++y)
+        {
+            LifeState cell;
+            cell.setCell(x, y, 1);
+            hashes.push_back(cell.getHash());
+        }
+    }
+    std::sort(hashes.begin(), hashes.end());
+    status = status && (std::unique(hashes.begin(), hashes.end()) == hashes.end());
+    // Changing a cell updates the hash through its row alone.
+    uint64_t lo, hi;
+    soup.getHash128(lo, hi);
+    LifeState changed = soup;
+    changed.setCell(2, 3, 1 - soup.getCell(2, 3));
+    uint64_t before = 0, after = 0;
+    for (int y=-32; y<32; ++y)
+    {
+        before |= (uint64_t)soup.getCell(2, y) << (y + 32);
+        after |= (uint64_t)changed.getCell(2, y) << (y + 32);
+    }
+    uint64_t updated = lo ^ LifeState::rowHash(2 + 32, before) ^ LifeState::rowHash(2 + 32, after);
+    uint64_t changedLo, changedHi;
+    changed.getHash128(changedLo, changedHi);
+    // Two rows whose words differ by the XOR of their row keys don't cancel.
+    uint64_t key = 0x9E3779B97F4A7C15ULL;
+    uint64_t word = 0x0123456789ABCDEFULL;
+    uint64_t other = word ^ (1 * key) ^ (2 * key);
+    LifeState pair;
+    for (int y=-32; y<32; ++y)
+    {
+        pair.setCell(-32, y, (int)((word >> (y + 32)) & 1));
+        pair.setCell(-31, y, (int)((other >> (y + 32)) & 1));
+    }
+    status = status && (pair.getHash() != LifeState().getHash());
+    return status && (updated == changed.getHash()) && (changedLo == updated) && (changedHi != hi);
+}
+
+bool testTranspositionTable01()
+{
+    TranspositionTable table(10);
+    bool status = (table.capacity() == 1024);
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-8, -8, 16, 16);
+    status = status && !table.insert(soup.getHash()) && table.insert(soup.getHash());
+    status = status && table.contains(soup.getHash()) && !table.contains(soup.after(1).getHash());
+    // A full table forgets old hashes but keeps taking new ones.
+    for (uint64_t h=1; h<=100000; ++h)
+    {
+        table.insert(h * 0x9E3779B97F4A7C15ULL);
+    }
+    status = status && table.contains(100000 * 0x9E3779B97F4A7C15ULL);
+    table.clear();
+    return status && !table.contains(soup.getHash());
+}
+
 bool testLifeLocator01()
 {
     CellList wanted = glider.toLifeLocator().withBoundary().on;
@@ -203,6 +729,123 @@ bool testRemoveGliders01()
     return status;
 }
 
+bool testRemoveGliders02()
+{
+    // With removal off the glider just wraps around.
+    LifeState a = glider;
+    a.setGliderRemoval(GLIDERS_OFF);
+    a.run(256);
+    bool status = (a == glider) && (a.getGliderCount() == 0);
+    // Periodic checks catch every glider, whatever its phase at the check.
+    int matrices[4][4] = {{1, 0, 0, 1}, {0, -1, 1, 0}, {-1, 0, 0, -1}, {0, 1, -1, 0}};
+    int periods[] = {1, 3, 4, 8, 13, 32};
+    for (int i=0; i<4; ++i)
+    {
+        int* m = matrices[i];
+        for (size_t p=0; p<sizeof(periods) / sizeof(periods[0]); ++p)
+        {
+            LifeState b = glider.transform(0, 0, m[0], m[1], m[2], m[3]);
+            LifeEventSink sink;
+            b.setEventSink(&sink);
+            b.setGliderRemoval(GLIDERS_PERIODIC, periods[p]);
+            b.run(200);
+            std::vector<GliderData> found = b.getGliders();
+            status = status && (b.getPop() == 0) && (found.size() == 1);
+            status = status && (found.size() == 0 || (found[0].dx == (m[0] + m[1] > 0) && found[0].dy == (m[2] + m[3] > 0)));
+        }
+    }
+    return status;
+}
+
+bool testEventSink01()
+{
+    // Copies share the sink, while the records are their own.
+    LifeEventSink sink;
+    LifeState a = glider;
+    a.setEventSink(&sink);
+    LifeState b = a.transform(0, 0, -1, 0, 0, -1);
+    a.run(200);
+    bool status = (a.getGliderCount() == 1) && (b.getGliderCount() == 0) && (sink.gliders.size() == 1);
+    b.run(200);
+    status = status && (b.getGliderCount() == 1) && (sink.gliders.size() == 2) && (b.getGliders().size() == 1);
+    status = status && (b.getGliders()[0].dx == sink.gliders[1].dx) && (a.getGliders()[0].dx == sink.gliders[0].dx);
+    // With no sink the gliders are still recorded.
+    LifeState c = glider;
+    c.run(200);
+    status = status && (c.getGliderCount() == 1) && (c.getGliders().size() == 1);
+    // Past GLIDER_RECORDS only the count goes on.
+    LifeState e = glider;
+    for (int i=0; i<LifeState::GLIDER_RECORDS + 2; ++i)
+    {
+        e.run(200);
+        e |= glider;
+    }
+    status = status && (e.getGliderCount() == LifeState::GLIDER_RECORDS + 2)
+        && ((int)e.getGliders().size() == LifeState::GLIDER_RECORDS);
+    // States copy as plain memory.
+    LifeState d;
+    std::memcpy((void*)&d, (const void*)&a, sizeof(LifeState));
+    c.clear();
+    return status && (d == a) && (d.getGen() == a.getGen()) && (c.getGliderCount() == 0);
+}
+
+bool testSpaceships01()
+{
+    SpaceshipCatalog catalog;
+    catalog.addStandardShips();
+    bool status = (catalog.size() == 4);
+    // A blinker doesn't move and a pattern that changes shape isn't a ship.
+    status = status && (catalog.add("3o!", 2) == -1) && (catalog.add("2o$o!", 4) == -1);
+    // Ships share most of their tests.
+    int separate = 0;
+    const char* ships[] = {"bo$2bo$3o!", "bo2bo$o4b$o3bo$4o!", "3bo2b$bo3bo$o5b$o4bo$5o!", "3b2o2b$bo4bo$o6b$o5bo$6o!"};
+    for (int i=0; i<4; ++i)
+    {
+        SpaceshipCatalog single;
+        single.add(ships[i], 4);
+        separate += single.getNodeCount();
+    }
+    status = status && (catalog.getNodeCount() < separate);
+    // A still life never reaches the edge.
+    LifeState block("2o$2o!");
+    LifeState a = block;
+    a.setSpaceshipCatalog(&catalog);
+    a.run(200);
+    return status && (a == block) && (a.getSpaceshipCount() == 0);
+}
+
+bool testSpaceships02()
+{
+    SpaceshipCatalog catalog;
+    catalog.addStandardShips();
+    const char* ships[] = {"bo$2bo$3o!", "bo2bo$o4b$o3bo$4o!", "3bo2b$bo3bo$o5b$o4bo$5o!", "3b2o2b$bo4bo$o6b$o5bo$6o!"};
+    int directions[4][2] = {{1, 1}, {-1, 0}, {-1, 0}, {-1, 0}};
+    int matrices[4][4] = {{1, 0, 0, 1}, {0, -1, 1, 0}, {-1, 0, 0, -1}, {0, 1, -1, 0}};
+    bool status = true;
+    for (int i=0; i<4; ++i)
+    {
+        for (int j=0; j<4; ++j)
+        {
+            int* m = matrices[j];
+            LifeState a = LifeState(ships[i]).transform(0, 0, m[0], m[1], m[2], m[3]);
+            LifeEventSink sink;
+            a.setEventSink(&sink);
+            a.setGliderRemoval(GLIDERS_OFF);
+            a.setSpaceshipCatalog(&catalog);
+            a.run(300);
+            std::vector<SpaceshipData> found = a.getSpaceships();
+            status = status && (a.getPop() == 0) && (found.size() == 1);
+            if (found.size() == 1)
+            {
+                status = status && (found[0].ship == i);
+                status = status && (found[0].dx == m[0] * directions[i][0] + m[1] * directions[i][1]);
+                status = status && (found[0].dy == m[2] * directions[i][0] + m[3] * directions[i][1]);
+            }
+        }
+    }
+    return status;
+}
+
 bool testPatternMatching01()
 {
     // The objects
@@ -249,6 +892,424 @@ bool testPatternMatching02()
     return (gliders == LifeState());
 }
 
+bool testPatternMatching03()
+{
+    // The compiled locator agrees with matching ON and OFF cells separately.
+    LifeLocator locators[] = {
+        LifeLocator("2o$2o!").withBoundary(),
+        glider.toLifeLocator().withBoundary(),
+        LifeLocator("o$o$o!", 30, -33),
+        LifeLocator(LifeState("o!"), LifeState("bo!"))
+    };
+    bool status = true;
+    for (int n=0; n<50; ++n)
+    {
+        LifeState soup = LifeState::makeRandomState();
+        if (n % 2 == 1)
+        {
+            soup = soup & LifeState::makeRandomState() & LifeState::makeRect(-20, 5, 30, 40);
+        }
+        for (size_t i=0; i<sizeof(locators) / sizeof(locators[0]); ++i)
+        {
+            const LifeLocator& l = locators[i];
+            status = status && (soup.locate(l) == (soup.locate(l.on, true) & soup.locate(l.off, false)));
+        }
+    }
+    // Changed cells take effect once recompiled.
+    LifeLocator l = locators[0];
+    l.off.clear();
+    l.compile();
+    LifeState blocks = LifeState("2o$2o!") | LifeState("3o$3o!", 10, 10);
+    status = status && (blocks.locate(l).getPop() == 3) && (blocks.locate(locators[0]).getPop() == 1);
+    // Or at the next locate().
+    LifeLocator lazy = locators[0];
+    lazy.off.clear();
+    return status && (blocks.locate(lazy).getPop() == 3) && (blocks.locate(lazy, 1).getPop() >= 3);
+}
+
+bool testPatternMatching04()
+{
+    // A library matched in one sweep agrees with locating one at a time.
+    const char* objects[] = {"2o$2o!", "b2o$o2bo$b2o!", "bo$obo$obo$bo!", "3o!", "o$o$o!", "2o$obo$bo!"};
+    std::vector<LifeLocator> library;
+    for (size_t i=0; i<sizeof(objects) / sizeof(objects[0]); ++i)
+    {
+        library.push_back(LifeLocator(objects[i]).withBoundary());
+    }
+    LifeState phase = glider;
+    for (int p=0; p<4; ++p)
+    {
+        library.push_back(phase.toLifeLocator().withBoundary());
+        phase = phase.after(1);
+    }
+    library.push_back(LifeLocator(LifeState(), LifeState()));
+    // Offsets a torus width apart test the same cells.
+    LifeLocator far = library[1];
+    for (size_t n=0; n<far.on.size(); ++n)
+    {
+        far.on[n].x += 256;
+    }
+    for (size_t n=0; n<far.off.size(); ++n)
+    {
+        far.off[n].y -= 192;
+    }
+    library.push_back(far);
+    LocatorSet set;
+    bool status = (set.add(library[0]) == 0) && (set.add(std::vector<LifeLocator>(library.begin() + 1, library.end())) == 1);
+    status = status && (set.size() == (int)library.size());
+    for (int n=0; n<20; ++n)
+    {
+        LifeState soup = (LifeState::makeRandomState() & LifeState::makeRect(-16, -16, 32, 32));
+        soup.run(n * 5 + 1);
+        std::vector<LifeState> matches = set.locate(soup);
+        for (int i=0; i<set.size(); ++i)
+        {
+            status = status && (matches[i] == soup.locate(set[i]));
+        }
+    }
+    return status;
+}
+
+bool testPatternMatching05()
+{
+    // Mismatch counts against a cell by cell count.
+    LifeLocator l = glider.toLifeLocator().withBoundary();
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRandomState();
+    bool status = true;
+    for (int k=0; k<=5; ++k)
+    {
+        LifeState found = soup.locate(l, k);
+        for (int x=-32; x<32; ++x)
+        {
+            for (int y=-32; y<32; ++y)
+            {
+                int mismatches = 0;
+                for (size_t n=0; n<l.on.size(); ++n)
+                {
+                    mismatches += 1 - soup.getCell(((x + l.on[n].x + 96) & 63) - 32, ((y + l.on[n].y + 96) & 63) - 32);
+                }
+                for (size_t n=0; n<l.off.size(); ++n)
+                {
+                    mismatches += soup.getCell(((x + l.off[n].x + 96) & 63) - 32, ((y + l.off[n].y + 96) & 63) - 32);
+                }
+                status = status && (found.getCell(x, y) == (mismatches <= k ? 1 : 0));
+            }
+        }
+    }
+    // A block with a cell missing is a near miss.
+    LifeState damaged("2o$bo!", 5, 5);
+    LifeLocator block = LifeLocator("2o$2o!").withBoundary();
+    status = status && (damaged.locate(block) == LifeState());
+    status = status && (damaged.locate(block, 1).getPop() == 1) && (damaged.locate(block, 1).getCell(5, 5) == 1);
+    // A limit past the locator's size matches everywhere.
+    status = status && (damaged.locate(block, 16).getPop() == 64 * 64) && (damaged.locate(block, 2147483647).getPop() == 64 * 64);
+    return status;
+}
+
+bool testLifeGrid01()
+{
+    // A glider crossing several tile boundaries.
+    LifeGrid grid(300, 200);
+    grid.join(glider, 10, 10);
+    grid.run(400);
+    return (grid.getPop() == 5) && (grid.toLifeState(110, 110) == glider);
+}
+
+bool testLifeGrid02()
+{
+    // A soup on a tile corner evolves like it does in a LifeState.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-8, -8, 16, 16);
+    LifeGrid grid(256, 256);
+    grid.join(soup, 128, 128);
+    grid.run(20);
+    return grid.toLifeState(128, 128) == soup.after(20);
+}
+
+bool testHashLife01()
+{
+    // A glider a million generations later.
+    HashLife universe(glider);
+    universe.run(1 << 20);
+    int d = (1 << 20) / 4;
+    bool status = (universe.getPop() == 5) && (universe.toLifeState(d, d) == glider)
+        && (universe.getGen() == (1 << 20));
+    // Past the range of an int.
+    universe.step(40);
+    return status && (universe.getPop() == 5) && (universe.getGen() == (1LL << 40) + (1 << 20));
+}
+
+bool testHashLife02()
+{
+    // Small steps must agree with LifeState while nothing reaches the edge.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-6, -6, 12, 12);
+    HashLife universe(soup);
+    universe.step(3);
+    universe.run(12);
+    return universe.toLifeState() == soup.after(20);
+}
+
+bool testHashLife03()
+{
+    // Evicting nodes must not change the results.
+    LifeState r_pentomino("b2o$2o$bo!");
+    HashLife big(r_pentomino);
+    HashLife small(r_pentomino, 2000);
+    for (int i=0; i<50; ++i)
+    {
+        big.run(37);
+        small.run(37);
+    }
+    return (big.getPop() == small.getPop())
+        && (big.toLifeState() == small.toLifeState())
+        && (small.getNodeCount() < big.getNodeCount());
+}
+
+bool testLifeBatch01()
+{
+    // Batched states evolve like separate LifeStates.
+    const size_t n = 40;
+    std::vector<LifeState> soups;
+    LifeBatch batch(n);
+    for (size_t i=0; i<n; ++i)
+    {
+        soups.push_back(LifeState::makeRandomState() & LifeState::makeRect(-6, -6, 12, 12));
+        batch.setState(i, soups[i]);
+    }
+    batch.run(15);
+    bool status = true;
+    for (size_t i=0; i<n; ++i)
+    {
+        status = status && (batch.getState(i) == soups[i].after(15));
+    }
+    return status;
+}
+
+bool testLifeBatch03()
+{
+    // A partly filled last block only touches the states that exist.
+    bool status = true;
+    for (size_t n=1; n<40; n+=7)
+    {
+        LifeBatch batch(n);
+        std::vector<LifeState> soups;
+        for (size_t i=0; i<n; ++i)
+        {
+            soups.push_back(LifeState::makeRandomState() & LifeState::makeRect(-5, -5, 10, 10));
+            batch.setState(i, soups[i]);
+        }
+        batch.run(6);
+        LifeState cell;
+        cell.setCell(0, 0, 1);
+        batch.runUntil(LifeTarget(cell, cell), 3); // Never matches
+        for (size_t i=0; i<n; ++i)
+        {
+            status = status && (batch.getGen(i) == 9) && (batch.getState(i) == soups[i].after(9));
+        }
+    }
+    return status;
+}
+bool testLifeBatch02()
+{
+    // Each glider stops when it reaches the target, the first one at once.
+    LifeTarget target = LifeTarget(glider).withBoundary();
+    LifeBatch batch(20);
+    for (int i=0; i<20; ++i)
+    {
+        batch.setState(i, glider.transform(-i, -i));
+    }
+    batch.setActive(19, false);
+    size_t matched = batch.runUntil(target, 72);
+    bool status = (matched == 19);
+    for (int i=0; i<19; ++i)
+    {
+        status = status && !batch.isActive(i) && (batch.getGen(i) == 4 * i);
+        status = status && (batch.getState(i) == glider);
+    }
+    return status && (batch.getGen(19) == 0);
+}
+
+bool testBasicLifeState01()
+{
+    // All widths agree with LifeState while nothing wraps.
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-6, -6, 12, 12);
+    LifeState expected = soup.after(8);
+    bool status = (LifeState32::fromLifeState(soup).after(8).toLifeState() == expected);
+    status = status && (LifeState64::fromLifeState(soup).after(8).toLifeState() == expected);
+#ifdef __SIZEOF_INT128__
+    status = status && (LifeState128::fromLifeState(soup).after(8).toLifeState() == expected);
+#endif
+    status = status && (LifeState256::fromLifeState(soup).after(8).toLifeState() == expected);
+    return status;
+}
+
+bool testBasicLifeState02()
+{
+    // A glider goes around the 32x32 torus in 128 generations,
+    // and travels 100 cells in a 256x256 one without wrapping.
+    LifeState32 small("bo$2bo$3o!");
+    LifeState256 big("bo$2bo$3o!");
+    LifeState256 expected("bo$2bo$3o!", 100, 100);
+    // The RLE code is shared with LifeState.
+    LifeState64 same("3o$bo$2b3o!");
+    return (small.after(128) == small) && (small.after(64) != small)
+        && (big.after(400) == expected) && (big.after(400).getPop() == 5)
+        && (same.toRLE() == LifeState("3o$bo$2b3o!").toRLE());
+}
+
+// Cell-by-cell reference for outer-totalistic rules on the torus.
+LifeState referenceStep(const LifeState& s, unsigned birth, unsigned survival)
+{
+    LifeState result;
+    for (int x=-32; x<32; ++x)
+    {
+        for (int y=-32; y<32; ++y)
+        {
+            int count = 0;
+            for (int dx=-1; dx<=1; ++dx)
+            {
+                for (int dy=-1; dy<=1; ++dy)
+                {
+                    if (dx || dy)
+                    {
+                        count += s.getCell((x + dx + 64) % 64, (y + dy + 64) % 64);
+                    }
+                }
+            }
+            unsigned mask = s.getCell(x, y) ? survival : birth;
+            result.setCell(x, y, (mask >> count) & 1);
+        }
+    }
+    return result;
+}
+
+template <class Rule>
+bool compareWithReference(const LifeState& start, int gens)
+{
+    LifeState expected = start;
+    for (int i=0; i<gens; ++i)
+    {
+        expected = referenceStep(expected, Rule::BIRTH, Rule::SURVIVAL);
+    }
+    return start.after<Rule>(gens) == expected;
+}
+
+bool testRules01()
+{
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-10, -10, 20, 20);
+    LifeState torus = LifeState::makeRandomState();
+    bool status = compareWithReference<HighLife>(soup, 12);
+    status = status && compareWithReference<HighLife>(torus, 5);
+    // Day & Night, Seeds and a B0 rule.
+    status = status && compareWithReference<LifeRule<0x1C8, 0x1D8> >(soup, 12);
+    status = status && compareWithReference<LifeRule<0x4, 0x0> >(soup, 6);
+    status = status && compareWithReference<LifeRule<0x9, 0x1FF> >(soup, 3);
+    // The generic circuit for B3/S23 matches the built-in kernel.
+    status = status && (soup.after<LifeRule<0x8 | 0x200, 0xC> >(30) == soup.after(30));
+    return status;
+}
+
+bool testRules02()
+{
+    unsigned birth = 0, survival = 0;
+    bool status = ParseRule("B36/S23", birth, survival) && birth == 0x48 && survival == 0xC;
+    status = status && ParseRule("s23/b3", birth, survival) && birth == 0x8 && survival == 0xC;
+    status = status && ParseRule("B2/S", birth, survival) && birth == 0x4 && survival == 0;
+    status = status && ParseRule("b3s23", birth, survival) && birth == 0x8 && survival == 0xC;
+    status = status && !ParseRule("B39/S23", birth, survival) && !ParseRule("B3", birth, survival);
+#if __cplusplus >= 201103L
+    typedef LifeRule<RuleBirth("B36/S23"), RuleSurvival("B36/S23")> Parsed;
+    status = status && (Parsed::TABLE == HighLife::TABLE);
+    status = status && (RuleBirth("b3s23") == 0x8) && (RuleSurvival("b3s23") == 0xC);
+    status = status && (RuleBirth("s23b36") == 0x48) && (RuleSurvival("s23b36") == 0xC);
+#endif
+    return status;
+}
+
+// Cell-by-cell reference for isotropic rules, using the rule's own table.
+LifeState referenceStep(const LifeState& s, const IsotropicRule& rule)
+{
+    // Neighbour offsets in Hensel order: N, NE, E, SE, S, SW, W, NW.
+    static const int dx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    static const int dy[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+    LifeState result;
+    for (int x=-32; x<32; ++x)
+    {
+        for (int y=-32; y<32; ++y)
+        {
+            int index = s.getCell(x, y) ? IsotropicRule::CENTRE : 0;
+            for (int k=0; k<8; ++k)
+            {
+                index |= s.getCell((x + dx[k] + 64) % 64, (y + dy[k] + 64) % 64) << k;
+            }
+            result.setCell(x, y, rule.get(index));
+        }
+    }
+    return result;
+}
+
+bool testIsotropicRule01()
+{
+    bool status = IsotropicRule("B2-a/S12").isValid() && IsotropicRule("b3/s23").isValid();
+    status = status && !IsotropicRule("B2x/S").isValid() && !IsotropicRule("B0c/S").isValid();
+    status = status && !IsotropicRule("B1-/S").isValid() && !IsotropicRule("B3").isValid();
+    // 2a is two adjacent neighbours, 2e two edge neighbours a diagonal step
+    // apart (N and E), and 2k two a knight's move apart.
+    IsotropicRule b2a("B2a/S");
+    status = status && b2a.get(IsotropicRule::N | IsotropicRule::NE)
+        && b2a.get(IsotropicRule::W | IsotropicRule::SW)
+        && !b2a.get(IsotropicRule::N | IsotropicRule::E)
+        && !b2a.get(IsotropicRule::N | IsotropicRule::NE | IsotropicRule::CENTRE);
+    // The letters of each count split its neighbourhoods exactly.
+    const char* letters[9] = {"", "ce", "aceikn", "aceijknqry", "aceijknqrtwyz",
+                              "aceijknqry", "aceikn", "ce", ""};
+    for (int count=1; count<8; ++count)
+    {
+        std::vector<int> covered(256, 0);
+        for (const char* l=letters[count]; *l; ++l)
+        {
+            std::string rule = "B";
+            rule += char('0' + count);
+            rule += *l;
+            rule += "/S";
+            IsotropicRule single(rule.c_str());
+            for (int mask=0; mask<256; ++mask)
+            {
+                covered[mask] += single.get(mask);
+            }
+        }
+        for (int mask=0; mask<256; ++mask)
+        {
+            status = status && (covered[mask] == (__builtin_popcountll(mask) == count ? 1 : 0));
+        }
+    }
+    return status;
+}
+
+bool testIsotropicRule02()
+{
+    LifeState soup = LifeState::makeRandomState() & LifeState::makeRect(-10, -10, 20, 20);
+    // Totalistic strings behave like the outer-totalistic rules.
+    bool status = soup.after(IsotropicRule("B3/S23"), 30) == soup.after(30);
+    LifeState expected = soup;
+    for (int i=0; i<12; ++i)
+    {
+        expected = referenceStep(expected, 0x48, 0xC);
+    }
+    status = status && soup.after(IsotropicRule("B36/S23"), 12) == expected;
+    const char* rules[3] = {"B2-a3/S12-i", "B2n3-q4t/S1c23-ck", "B0/S8"};
+    for (int r=0; r<3; ++r)
+    {
+        IsotropicRule rule(rules[r]);
+        expected = soup;
+        for (int i=0; i<6; ++i)
+        {
+            expected = referenceStep(expected, rule);
+        }
+        status = status && soup.after(rule, 6) == expected;
+    }
+    return status;
+}
+
 // Tests from UnitTest.c
 
 // Test 01. Find 2B+G collisions that return one or more gliders.
@@ -390,6 +1451,7 @@ bool testSimkin03()
                     }
                     LifeState state = pattern | gliders;
                     LifeState backup = state;
+                    (void)backup; // Only printed when debugging.
                     state.run(60);
                     if (state.contains(target_on) && (~state).contains(target_off))
                     {
@@ -423,11 +1485,47 @@ int main(void)
     testWithMsg(testOpPlusMinus, "Operator +, - test");
     testWithMsg(testTransform01, "LifeState transformation test 01");
     testWithMsg(testTransform02, "LifeState transformation test 02");
+    testWithMsg(testTransform03, "LifeState transformation test 03 - Orientations");
+    testWithMsg(testMove01, "LifeState move test 01");
+    testWithMsg(testOperators01, "LifeState operator test 01");
+    testWithMsg(testOperators02, "LifeState operator test 02 - Expressions");
+    testWithMsg(testCanonical01, "LifeState canonical form test 01");
+    testWithMsg(testConvolve01, "LifeState convolution test 01");
+    testWithMsg(testBounds01, "LifeState bounds test 01");
+    testWithMsg(testSimdKernels01, "SIMD iterate kernels test 01");
+    testWithMsg(testFusedRun01, "Fused run test 01");
+    testWithMsg(testStability01, "Stability test 01 - Still lifes, oscillators and spaceships");
+    testWithMsg(testCollision01, "Collision test 01 - Merge at the first contact");
+    testWithMsg(testCollision02, "Collision test 02 - Agrees with run() at every generation");
+    testWithMsg(testHash01, "Hash test 01 - Strong and translation-invariant hashes");
+    testWithMsg(testTranspositionTable01, "Hash test 02 - Transposition table");
+    testWithMsg(testCellList01, "CellList test 01 - Scanning cells");
     testWithMsg(testLifeLocator01, "LifeLocator basic test - Wanted Cells");
     testWithMsg(testLifeLocator02, "LifeLocator basic test - Unwanted Cells");
     testWithMsg(testRemoveGliders01, "Glider Removal test 01");
+    testWithMsg(testRemoveGliders02, "Glider Removal test 02 - Removal policies");
+    testWithMsg(testEventSink01, "Glider Removal test 03 - Event sinks");
+    testWithMsg(testSpaceships01, "Spaceship test 01 - Catalog");
+    testWithMsg(testSpaceships02, "Spaceship test 02 - Escaping ships");
     testWithMsg(testPatternMatching01, "Pattern matching basic test 01 - Locating");
     testWithMsg(testPatternMatching02, "Pattern matching basic test 02 - Removal");
+    testWithMsg(testPatternMatching03, "Pattern matching basic test 03 - Compiled locators");
+    testWithMsg(testPatternMatching04, "Pattern matching basic test 04 - Locator sets");
+    testWithMsg(testPatternMatching05, "Pattern matching basic test 05 - Mismatch tolerance");
+    testWithMsg(testLifeGrid01, "LifeGrid test 01 - Glider across tiles");
+    testWithMsg(testLifeGrid02, "LifeGrid test 02 - Compare with LifeState");
+    testWithMsg(testHashLife01, "HashLife test 01 - Glider after 2^20 generations");
+    testWithMsg(testHashLife02, "HashLife test 02 - Compare with LifeState");
+    testWithMsg(testHashLife03, "HashLife test 03 - Bounded node cache");
+    testWithMsg(testLifeBatch01, "LifeBatch test 01 - Compare with LifeState");
+    testWithMsg(testLifeBatch02, "LifeBatch test 02 - Early exit on target");
+    testWithMsg(testLifeBatch03, "LifeBatch test 03 - Batch sizes off the block size");
+    testWithMsg(testBasicLifeState01, "BasicLifeState test 01 - Compare with LifeState");
+    testWithMsg(testBasicLifeState02, "BasicLifeState test 02 - Gliders on small and big tori");
+    testWithMsg(testRules01, "Rule test 01 - Compare with reference");
+    testWithMsg(testRules02, "Rule test 02 - Rulestring parsing");
+    testWithMsg(testIsotropicRule01, "Isotropic rule test 01 - Hensel notation");
+    testWithMsg(testIsotropicRule02, "Isotropic rule test 02 - Compare with reference");
     testWithMsg(testSimkin01, "Advanced test from Michael Simkin #01 - Glider collisions");
     testWithMsg(testSimkin02, "Advanced test from Michael Simkin #02 - Dart synthesis");
     testWithMsg(testSimkin03, "Advanced test from Michael Simkin #03 - Bi-snake synthesis");